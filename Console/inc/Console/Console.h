@@ -76,6 +76,8 @@ public:
 
     bool InputPending(const std::chrono::milliseconds& waitTime = 500ms)
         {return m_input.InputPending(waitTime);}
+    void Wake()
+        {m_input.Wake();}
     bool PutInput(const input_t code)
         {return m_input.PutInput(code);}
     bool PutMacro(const input_t code)
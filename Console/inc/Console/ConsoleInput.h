@@ -135,6 +135,8 @@ public:
     virtual bool Init() = 0;
     virtual void Deinit() = 0;
     virtual bool InputPending(const std::chrono::milliseconds& WaitTime = 500ms) = 0;
+    //break input waiting from other thread
+    virtual void Wake() = 0;
 
     static std::string CastKeyCode(input_t code);
 };
@@ -124,6 +124,7 @@ class InputTTY final: public ConsoleInput
     KeyMapper       m_KeyMap;
 
     int             m_stdin {-1};
+    int             m_wake[2] {-1, -1};//pipe for waking up from other thread
     bool            m_fTerm{false};
 #ifdef __linux__    
     bool            m_fTiocLinux{false}; //linux only
@@ -143,6 +144,7 @@ public:
     virtual bool    Init() override final;
     virtual void    Deinit() final;
     virtual bool    InputPending(const std::chrono::milliseconds& WaitTime = 500ms) override  final;
+    virtual void    Wake() override final;
 
 private:
     static void     Abort(int signal);
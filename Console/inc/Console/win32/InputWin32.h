@@ -65,6 +65,7 @@ public:
     virtual bool Init() override final;
     virtual void Deinit() override  final;
     virtual bool InputPending(const std::chrono::milliseconds& WaitTime = 500ms) override  final;
+    virtual void Wake() override final {}//there are no waked sources on windows
 
 protected:
     static BOOL InputWin32::CtrlHandler(DWORD fdwCtrlType);
@@ -173,6 +173,17 @@ bool InputTTY::Init()
 
     m_fTerm = true;
 
+    if(0 == pipe(m_wake))
+    {
+        for(auto fd : m_wake)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    else
+        m_wake[0] = m_wake[1] = -1;
+
     rc = LoadKeyCode();
 
     InitSignals();
@@ -199,6 +210,13 @@ void InputTTY::Deinit()
     while((-1 == close(m_stdin)) && (errno == EINTR));
     m_stdin = -1;
 
+    for(auto& fd : m_wake)
+    {
+        if(fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+
     DeinitMouse();
 
     LOG(DEBUG) << "Deinited";
@@ -294,6 +312,13 @@ bool InputTTY::InputPending(const std::chrono::milliseconds& WaitTime)
     FD_SET(m_stdin, &Read_FD_Set);
 
     int sel = m_stdin;
+    if(m_wake[0] >= 0)
+    {
+        FD_SET(m_wake[0], &Read_FD_Set);
+        if(m_wake[0] > sel)
+            sel = m_wake[0];
+    }
+
     int mouse_fd = GetMouseFD();
 
     if(mouse_fd > 0)
@@ -306,9 +331,16 @@ bool InputTTY::InputPending(const std::chrono::milliseconds& WaitTime)
     int rc = select(sel + 1, &Read_FD_Set, NULL, NULL, &wait);
     if(rc > 0)
     {
+        if(m_wake[0] >= 0 && FD_ISSET(m_wake[0], &Read_FD_Set))
+        {
+            //waked up without input
+            char buff[64];
+            while(read(m_wake[0], buff, sizeof(buff)) > 0);
+        }
+
         if(FD_ISSET(m_stdin, &Read_FD_Set))
             ProcessInput(false);
-        else
+        else if(mouse_fd > 0 && FD_ISSET(mouse_fd, &Read_FD_Set))
             ProcessInput(true);
     }
     else if(rc == 0)
@@ -321,6 +353,15 @@ bool InputTTY::InputPending(const std::chrono::milliseconds& WaitTime)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+void InputTTY::Wake()
+{
+    if(m_wake[1] >= 0)
+    {
+        [[maybe_unused]] auto rc = write(m_wake[1], "w", 1);
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 size_t InputTTY::ReadConsole(std::string& str, size_t n)
 {
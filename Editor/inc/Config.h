@@ -47,6 +47,12 @@ class EditorConfig
     inline static const std::string ShowAccessMenuKey   { "ShowAccessMenu" };
     inline static const std::string ShowClockKey        { "ShowClock" };
     inline static const std::string FileSaveTimeKey     { "FileSaveTime" };
+    inline static const std::string PieceTableSizeKey   { "PieceTableSize" };
+    inline static const std::string LoadThreadsKey      { "LoadThreads" };
+    inline static const std::string ProgressiveLoadKey  { "ProgressiveLoadSize" };
+    inline static const std::string IndexCacheKey       { "IndexCacheSize" };
+    inline static const std::string AtomicSaveKey       { "AtomicSave" };
+    inline static const std::string EditJournalKey      { "EditJournal" };
 
 public:
     inline static const std::string ConfigDir           { "config" };
@@ -54,9 +60,15 @@ public:
 
     std::string colorFile       {"default.clr"};
     std::string keyFile         {"default.kmap"};
-    uint32_t    fileSaveTime    {0};
+    uint32_t    fileSaveTime    {0};//sec, changed files are saved in background after this time, 0 - never
+    uint32_t    pieceTableSize  {0};//MB, bigger files use piece table, 0 - never
+    uint32_t    loadThreads     {0};//threads for indexing of big files, 0 - all cores
+    uint32_t    progressiveLoadSize {64};//MB, bigger files are indexed in background, 0 - never
+    uint32_t    indexCacheSize  {256};//MB, string index of bigger files is saved for next opening, 0 - never
     bool        showAccessMenu  {true};
     bool        showClock       {true};
+    bool        atomicSave      {true};//file is saved to temporary one and renamed, else it is overwritten
+    bool        editJournal     {true};//changes are journaled for recovery after crash
 
     bool        m_changed{};
 
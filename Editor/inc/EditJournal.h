@@ -0,0 +1,101 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "UndoList.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace _Editor
+{
+
+//append-only journal of editing commands for recovery after crash,
+//commands are collected in memory and written with sync in batches by timer
+class EditJournal
+{
+    inline static const std::string c_magic{ "MJRN" };
+    static constexpr uint32_t       c_version{ 1 };
+    static constexpr size_t         c_flushSize{ 0x10000 };//pending commands are written without timer
+
+public:
+    //state of file the journal is applied to
+    struct Header
+    {
+        std::string     filePath;//absolute u8 path
+        uint64_t        fileSize{};
+        int64_t         fileTime{};
+        std::string     cp;
+        std::string     parseStyle;
+    };
+
+private:
+#ifdef WIN32
+    void*                   m_file{};
+#else
+    int                     m_file{-1};
+#endif
+    std::filesystem::path   m_path;
+    std::string             m_pending;  //not written commands
+    std::string             m_marked;   //commands after mark, they stay in journal of saved file
+    bool                    m_mark{};
+
+    bool    Create(const std::filesystem::path& path, const Header& header);
+    bool    Write(const std::string& data);
+
+public:
+    EditJournal() = default;
+    EditJournal(const EditJournal&) = delete;
+    void operator= (const EditJournal&) = delete;
+    ~EditJournal() { Close(); }
+
+    //journal is locked while editor works with it
+    static bool IsLocked(const std::filesystem::path& path);
+    //commands are read up to the first broken record
+    static bool Read(const std::filesystem::path& path, Header& header, std::vector<EditCmd>* cmds = nullptr);
+
+    bool    Open(const std::filesystem::path& path, const Header& header);
+    void    Close(bool remove = false);
+#ifdef WIN32
+    bool    IsOpen() const  { return m_file != nullptr; }
+#else
+    bool    IsOpen() const  { return m_file >= 0; }
+#endif
+
+    void    Add(cmd_t command, size_t line, size_t pos, size_t count, size_t len, const std::u16string& str);
+    bool    Flush();
+
+    //commands after mark are moved to journal of file saved in background
+    void    Mark()          { m_mark = true; m_marked.clear(); }
+    void    Unmark()        { m_mark = false; m_marked.clear(); }
+    bool    Rebase(const Header& header);
+};
+
+} //namespace _Editor
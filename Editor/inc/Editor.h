@@ -27,16 +27,29 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "utils/MemBuff.h"
+#include "utils/MappedFile.h"
+#include "utils/AsyncReader.h"
+#include "utils/FileWatcher.h"
+#include "utils/AtomicFile.h"
+#include "utils/PieceTable.h"
 #include "Console/Types.h"
 #include "UndoList.h"
+#include "EditJournal.h"
 #include "WndManager/Wnd.h"
 #include "LexParser.h"
 
 #include <unordered_set>
 #include <filesystem>
+#include <fstream>
 #include <limits>
 #include <algorithm>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <map>
 
 
 #if !defined(__APPLE__) && !defined(__FreeBSD__)
@@ -87,12 +100,17 @@ constexpr size_t    STR_NOTDEFINED{ std::numeric_limits<size_t>::max() };
 constexpr uintmax_t MAX_PARSED_SIZE{ 0x2000000 }; // 32 MB
 
 constexpr size_t    c_buffsize{ 0x200000 };//2MB
-using read_buff_t = std::array<char, c_buffsize>;
+constexpr uintmax_t c_blocksPerFile{ 0x400 };//block size is increased for bigger files
+constexpr uintmax_t c_loadChunkSize{ 0x400000 };//4MB, min part of file indexed by one thread
 
 class Editor
 {
     inline const static std::string     c_utf8Bom{ "\xef\xbb\xbf" };
     inline const static std::u16string  c_utf16Bom{ u"\xfeff" };
+    inline const static std::string     c_indexCacheDir{ ".m.idx" };
+    static constexpr size_t             c_indexCacheFiles{ 64 };//the least recently used indexes are removed over it
+    inline const static std::string     c_journalDir{ ".m.jrn" };
+    static constexpr uint32_t           c_indexCacheVer{ 1 };
 
 private:
     std::shared_ptr<iconvpp::CpConverter>       m_converter;
@@ -100,12 +118,24 @@ private:
     std::filesystem::path                       m_file;
     std::filesystem::file_time_type             m_fileTime{};
     uintmax_t                                   m_fileSize{};
+    uint64_t                                    m_fileId{};//inode for detecting of log rotation
+    FileWatcher::watch_t                        m_watch{ FileWatcher::c_invalid };//change notification of file
+    std::filesystem::path                       m_watchPath;
+    uint32_t                                    m_watchEvents{};
     MemStrBuff<std::string, std::string_view>   m_buffer;
+    MappedFile                                  m_mapFile;//not modified blocks are read from it
+    AsyncReader                                 m_reader{1};//or from file if it can't be mapped
+    PieceTable<std::string, std::string_view>   m_pieces;//storage over mapped file
+    bool                                        m_usePieces{};
 
     std::unordered_set<FrameWnd*>               m_wndList;
 
     UndoList        m_undoList;
     LexParser       m_lexParser;
+    EditJournal     m_journal;      //edit commands for recovery after crash
+    bool            m_journalOff{}; //journal can't be used for file
+    time_t          m_changeTime{}; //the first not saved change for autosave
+    uint64_t        m_editCount{};  //journaled changes, background saving compares it with snapshot
 
     //config variables
     std::string     m_cp{};
@@ -116,17 +146,106 @@ private:
     bool            m_showTab{};
     bool            m_ro{};
     bool            m_bom{};
+    bool            m_improveAll{};//saving options were changed, all strings will be improved
 
     //editor variables
     std::u16string  m_curStrBuff;
     size_t          m_curStr{STR_NOTDEFINED};
     bool            m_curChanged{};
 
-    bool    ApplyBuffer(const std::shared_ptr<read_buff_t>& buff, size_t read, size_t& buffOffset,
-        std::shared_ptr<StrBuff<std::string, std::string_view>>& strBuff, size_t& strOffset,
-        uintmax_t& fileOffset, bool eof);
-    bool    FillStrOffset(std::shared_ptr<StrBuff<std::string, std::string_view>> strBuff, size_t size, bool last, size_t& rest);
-    bool    ImproveBuff(std::list<std::shared_ptr<StrBuff<std::string, std::string_view>>>::iterator strBuff);
+    //background indexing of file after the first screen
+    using strbuff_ptr = std::shared_ptr<StrBuff<std::string, std::string_view>>;
+    std::thread             m_indexThread;
+    std::mutex              m_indexMutex;
+    std::condition_variable m_indexCond;
+    std::vector<strbuff_ptr> m_indexed;     //ready blocks, they are added to buffer in UI thread
+    std::atomic<uint64_t>   m_indexOffset{};
+    std::atomic_bool        m_indexCancel{};
+    bool                    m_indexDone{};  //guarded by m_indexMutex
+    bool                    m_indexError{}; //guarded by m_indexMutex
+    bool                    m_indexing{};
+    std::thread             m_indexSaveThread;//index cache is written in background
+
+    //lexical scan of loaded blocks in background
+    std::thread             m_lexThread;
+    std::string_view        m_lexData;      //mapped file
+    std::mutex              m_lexMutex;
+    std::condition_variable m_lexCond;
+    std::deque<strbuff_ptr> m_lexQueue;     //blocks in file order
+    std::vector<std::map<size_t, std::string>> m_lexed;//scan results, they are merged in UI thread
+    size_t                  m_lexLine{};    //guarded by m_lexMutex
+    bool                    m_lexQueueEnd{};//guarded by m_lexMutex
+    bool                    m_lexCancel{};  //guarded by m_lexMutex
+    bool                    m_lexDone{};    //guarded by m_lexMutex
+    size_t                  m_lexMerged{};  //strings with merged lexical positions
+    bool                    m_lexing{};
+    //scan states for continuation by log tail, guarded by m_lexMutex
+    LexParser::LexState     m_lexBlockState;//before the last scanned block
+    size_t                  m_lexBlockLine{};
+    LexParser::LexState     m_lexEndState;  //after the last scanned block
+    size_t                  m_lexEndLine{};
+
+    //saving of snapshot in background, its blocks are shared with buffer and copied before changing
+    struct SaveBlock
+    {
+        strbuff_ptr             strBuff;
+        BuffPin<std::string>    pin;        //data of modified block
+        uint64_t                fileOffset{};//in original file
+        uint64_t                size{};
+    };
+    std::thread             m_saveThread;
+    std::vector<SaveBlock>  m_saveBlocks;
+    AtomicFile              m_saveFile;
+    std::atomic<uint64_t>   m_saveOffset{};
+    uint64_t                m_saveSize{};
+    uint64_t                m_saveEditCount{};//changes in snapshot
+    std::atomic_bool        m_saveDone{};
+    bool                    m_saveError{}; //set before m_saveDone
+    bool                    m_saving{};
+
+    bool    ReadBlocks(std::ifstream& file, uintmax_t fileOffset);
+    size_t  ScanStrOffset(const char* buff, size_t size, bool last, bool checkEol, const std::function<void(uint32_t)>& addStr);
+    bool    ImproveBuff(MemStrBuff<std::string, std::string_view>::BuffList::iterator strBuff);
+    bool    ImproveStr(std::string_view str, std::string& outstr);
+    bool    LoadPieces(uint64_t offset = 0);
+    bool    LoadPiecesTail();
+    bool    LoadParallel(size_t threads);
+    bool    IndexParallel(std::string_view data, uint64_t offset, size_t threads, std::vector<std::vector<strbuff_ptr>>& parts);
+    bool    LoadProgressive();
+    bool    IndexPart(std::string_view data, uint64_t offset, uint64_t end, const std::function<bool(strbuff_ptr)>& addBuff);
+    bool    StartIndex(std::string_view data, uint64_t offset);
+    void    StopIndex();
+    void    LexStr(LexParser& lexer, size_t line, std::string_view str) const;
+    bool    StartLex(std::string_view data, size_t line = 0, const LexParser::LexState& state = {});
+    void    LexBuff(const strbuff_ptr& strBuff);
+    void    EndLex();//all blocks are given to lexical scan
+    void    StopLex();
+    bool    RunLex(size_t line, const LexParser::LexState& state);
+    bool    SuspendLex(size_t line);//wait for scan of line and stop it keeping not scanned blocks
+    bool    ResumeLex(int64_t shift);//scan goes on with lines moved by editing
+
+    //cache of string index for big files
+    std::filesystem::path GetIndexPath() const;
+    std::string GetIndexKey() const;
+    bool    UseIndexCache() const;
+    bool    SaveIndex();
+    void    WaitIndexSave();
+    static bool WriteIndex(const std::filesystem::path& path, const std::string& data);
+    static void PruneIndexCache(const std::filesystem::path& dir);
+    bool    LoadIndex();
+    bool    SavePieces();
+    void    CheckMapping() const;//throw if not modified strings were lost by truncation of file
+    bool    SaveAtomic();
+    bool    StartSave();
+
+    //journal of changes
+    EditJournal::Header GetJournalHeader() const;
+    bool    AddEditCmd(cmd_t command, size_t line, size_t pos, size_t count, size_t len, const std::u16string& str);
+    void    Journal(cmd_t command, size_t line, size_t pos, size_t count, size_t len, const std::u16string& str);
+
+    //string storage selected for file
+    std::string_view GetBuffStr(size_t n)   {return m_usePieces ? m_pieces.GetStr(n) : m_buffer.GetStr(n);}
+    bool    ReleaseBuff()                   {return m_usePieces || m_buffer.ReleaseBuff();}
 
     std::u16string  _GetStr(size_t line, size_t offset, size_t size);
     bool    _AddStr(size_t n, const std::u16string& str);
@@ -135,6 +254,9 @@ private:
     bool    ChangeStr(size_t n, const std::u16string& str);
     bool    ConvertStr(const std::u16string& str, std::string& buff) const;
 
+    bool    OpenFile();
+    bool    Watch();
+    void    Unwatch();
     bool    LoadBuff(uint64_t offset, size_t size, std::shared_ptr<std::string> buff);
     bool    BackupFile();
     bool    Clear();
@@ -154,6 +276,7 @@ public:
         SetCP(cp);
         Clear();
     }
+    ~Editor();
 
     static size_t UStrLen(const std::u16string& str) 
     {
@@ -182,29 +305,51 @@ public:
 
     bool                    Load(bool log = false);
     bool                    LoadTail();
-    bool                    Save();
+    bool                    Save(bool background = false);
     bool                    SetName(const std::filesystem::path& file, bool copy);
     bool                    ClearModifyFlag();
     char                    GetAccessInfo();
     file_state              CheckFile();
+    bool                    IsFileModified() const;//file was changed on disk after loading or saving
+    bool                    IsWatched() const       {return m_watch != FileWatcher::c_invalid && m_watchPath == m_file;}
+    bool                    IsFileEvent();//file was changed by notification, CheckFile is needed
     bool                    IsFileInMemory();
+    MemStat                 GetMemStat() const      {return m_usePieces ? m_pieces.GetMemStat() : m_buffer.GetMemStat();}
+    bool                    UsePieceTable(bool use) {m_usePieces = use; return true;}
+    bool                    IsPieceTable() const    {return m_usePieces;}
+    void                    LogMemStat() const;
+    bool                    IsIndexing() const      {return m_indexing;}
+    bool                    UpdateIndex();//add strings indexed in background, true if string count was changed
+    bool                    WaitIndex(size_t line = STR_NOTDEFINED);//wait for indexing of line or of all file
+    bool                    UpdateLex();//merge results of lexical scan in background
+    bool                    WaitLex(size_t line = STR_NOTDEFINED);//wait for lexical scan of line or of all file
+    bool                    IsSaving() const        {return m_saving;}
+    bool                    UpdateSave();//finish saving in background, true if it was finished
+    bool                    WaitSave();
+    time_t                  GetChangeTime() const   {return m_changeTime;}
+
+    static std::filesystem::path GetJournalDir();
+    std::filesystem::path   GetJournalPath() const;
+    bool                    FlushJournal()          {return m_journal.Flush();}
+    bool                    Recover(const std::filesystem::path& journal);//replay commands from journal of crashed editor
+    void                    DiscardJournal()        {m_journal.Close(true);}//user doesn't save changes
 
     size_t                  GetMaxStrLen() const    {return m_maxStrlen;}
     void                    SetMaxStrLen(size_t len){m_maxStrlen = std::min(static_cast<size_t>(MAX_STRLEN), len);}
     std::string             GetCP() const           {return m_cp;}
     bool                    SetCP(const std::string& cp);
     eol_t                   GetEol() const          {return m_eol;}
-    void                    SetEol(eol_t eol)       {m_eol = eol;}
+    void                    SetEol(eol_t eol)       {m_improveAll |= m_eol != eol; m_eol = eol;}
     size_t                  GetTab() const          {return m_tab;}
     void                    SetTab(size_t tabsize);
     bool                    GetSaveTab() const      {return m_saveTab;}
-    void                    SetSaveTab(bool save)   {m_saveTab = save;}
+    void                    SetSaveTab(bool save)   {m_improveAll |= m_saveTab != save; m_saveTab = save;}
     bool                    GetShowTab() const      {return m_showTab;}
     void                    SetShowTab(bool show)   {m_lexParser.SetShowTab(m_showTab = show);}
 
-    size_t                  GetStrCount() const     {return m_buffer.GetStrCount(); }
-    bool                    IsChanged() const       {return m_curChanged || m_buffer.IsChanged(); }
-    uint64_t                GetSize() const         {return m_buffer.GetSize(); }
+    size_t                  GetStrCount() const     {return m_usePieces ? m_pieces.GetStrCount() : m_buffer.GetStrCount(); }
+    bool                    IsChanged() const       {return m_curChanged || (m_usePieces ? m_pieces.IsChanged() : m_buffer.IsChanged()); }
+    uint64_t                GetSize() const         {return m_usePieces ? m_pieces.GetSize() : m_buffer.GetSize(); }
     bool                    SetCurStr(size_t line);
     bool                    FlushCurStr();
 
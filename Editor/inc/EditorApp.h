@@ -26,6 +26,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "WndManager/App.h"
 #include "EditorWnd.h"
+#include "utils/StreamSpool.h"
 
 
 namespace _Editor
@@ -51,13 +52,17 @@ class EditorApp : public Application
     static std::unordered_map<AppCmd, AppFunc> s_funcMap;
     
     inline static const size_t c_maxRecentFiles{16};
+    inline static const uint32_t c_streamWait{200};//ms
     std::deque<file_t> m_recentFiles;
     std::unordered_map<Wnd*, std::shared_ptr<EditorWnd>> m_editors;
+    //streams spooled to temporary files
+    std::list<std::unique_ptr<StreamSpool>> m_streams;
 
     bool m_wait{};
     bool m_run{};
 
     bool CloseAllWindows();
+    bool IsStream(const std::filesystem::path& path) const;
     bool UpdateRecentFilesList();
 
 public:
@@ -103,6 +108,8 @@ public:
 
     Wnd* GetEditorWnd(std::filesystem::path path);
     bool OpenFile(const std::filesystem::path& path, const std::string& parseMode, const std::string& cp, bool ro = false, bool log = false);
+    bool OpenStream(int fd, const std::string& name);
+    bool RecoverFiles();//offer replay of journals left after crash
 
     //editor app commands
     bool    AboutProc(input_t cmd);
@@ -173,6 +173,7 @@ class EditorWnd : public FrameWnd
     bool    FindDown(bool silence = false);
     bool    IsWord(const std::u16string& str, size_t offset, size_t len);
     bool    CheckFileChanging();
+    bool    AutoSave();
     bool    ReplaceSubstr(size_t line, size_t pos, size_t len, const std::u16string& substr);
     bool    TryDeleteSelectedBlock();
 
@@ -215,6 +216,7 @@ public:
 
     bool    IsMarked()      { return IsSelectComplete(); }
     bool    IsChanged()     { return m_editor->IsChanged(); }
+    void    DiscardChanges(){ m_editor->DiscardJournal(); }
     bool    IsRO()          { return m_readOnly; }
     bool    SetRO(bool ro)  { return m_readOnly = ro; }
     bool    IsLog()         { return m_log; }
@@ -227,6 +229,7 @@ public:
 
     bool    SaveCfg(WndConfig& config);
     bool    LoadCfg(const WndConfig& config);
+    bool    Recover(const std::filesystem::path& journal);
 
 /*
   virtual Wnd*          GetLinkWnd() override   {return m_pTBuff->GetLinkWnd(this);}
@@ -95,6 +95,17 @@ class LexParser
 {
 public:
     inline static const std::string c_TextType{ "Text" };
+
+    //scan state between strings, it is needed for continuation of scan
+    struct LexState
+    {
+        std::list<char16_t> stringSymbol;
+        bool                cutLine{};
+        bool                commentLine{};
+        size_t              commentOpen{};
+        bool                commentToggled{};
+    };
+
     static std::map<std::string, LexConfig> s_lexConfig;
 
 protected:
@@ -156,6 +167,7 @@ public:
     static std::pair<size_t, std::string> GetFileType(const std::filesystem::path& name);
 
     bool    EnableParsing(bool scan)    { return m_scan = scan; }
+    bool    IsParsing() const           { return m_scan; }
     bool    SetParseStyle(const std::string& style = "");
     std::string GetParseStyle() const   {return m_parseStyle;}
 
@@ -164,7 +176,18 @@ public:
     bool    GetSaveTab() const          {return m_saveTab;}
     size_t  GetTabSize() const          {return m_tabSize;}
 
-    bool    Clear() { m_lexPosition.clear(); return true; }
+    bool    Clear(size_t line = 0) { m_lexPosition.erase(m_lexPosition.lower_bound(line), m_lexPosition.end()); return true; }
+    LexState GetState() const { return { m_stringSymbol, m_cutLine, m_commentLine, m_commentOpen, m_commentToggled }; }
+    void    SetState(const LexState& state)
+    {
+        m_stringSymbol = state.stringSymbol;
+        m_cutLine = state.cutLine;
+        m_commentLine = state.commentLine;
+        m_commentOpen = state.commentOpen;
+        m_commentToggled = state.commentToggled;
+    }
+    bool    TakeLexems(std::map<size_t, std::string>& lexems) { lexems.clear(); lexems.swap(m_lexPosition); return true; }
+    bool    MergeLexems(std::map<size_t, std::string>& lexems) { m_lexPosition.merge(lexems); return true; }
     bool    ScanStr(size_t line, std::string_view str, const std::string& cp);
     bool    GetColor(size_t line, const std::u16string& str, std::vector<color_t>& color, size_t len);
 
@@ -53,12 +53,24 @@ bool EditorConfig::Load(const path_t& file)
     config.showAccessMenu   = jsonConfig[ShowAccessMenuKey];
     config.showClock        = jsonConfig[ShowClockKey];
     config.fileSaveTime     = jsonConfig[FileSaveTimeKey];
+    config.pieceTableSize   = jsonConfig.value(PieceTableSizeKey, config.pieceTableSize);
+    config.loadThreads      = jsonConfig.value(LoadThreadsKey, config.loadThreads);
+    config.progressiveLoadSize = jsonConfig.value(ProgressiveLoadKey, config.progressiveLoadSize);
+    config.indexCacheSize   = jsonConfig.value(IndexCacheKey, config.indexCacheSize);
+    config.atomicSave       = jsonConfig.value(AtomicSaveKey, config.atomicSave);
+    config.editJournal      = jsonConfig.value(EditJournalKey, config.editJournal);
 
     colorFile       = config.colorFile;
     keyFile         = config.keyFile;
     showAccessMenu  = config.showAccessMenu;
     showClock       = config.showClock;
     fileSaveTime    = config.fileSaveTime;
+    pieceTableSize  = config.pieceTableSize;
+    loadThreads     = config.loadThreads;
+    progressiveLoadSize = config.progressiveLoadSize;
+    indexCacheSize  = config.indexCacheSize;
+    atomicSave      = config.atomicSave;
+    editJournal     = config.editJournal;
 
     return true;
 }
@@ -75,6 +87,12 @@ bool EditorConfig::Save(const path_t& file, bool force)
     json[ShowAccessMenuKey] = showAccessMenu;
     json[ShowClockKey]      = showClock;
     json[FileSaveTimeKey]   = fileSaveTime;
+    json[PieceTableSizeKey] = pieceTableSize;
+    json[LoadThreadsKey]    = loadThreads;
+    json[ProgressiveLoadKey] = progressiveLoadSize;
+    json[IndexCacheKey]     = indexCacheSize;
+    json[AtomicSaveKey]     = atomicSave;
+    json[EditJournalKey]    = editJournal;
 
     nlohmann::json jsonConfig;
     jsonConfig[ConfigKey] = json;
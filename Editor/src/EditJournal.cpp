@@ -0,0 +1,390 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "EditJournal.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/file.h>
+    #include <cerrno>
+#endif
+
+namespace _Editor
+{
+
+//record: u32 size | payload | u32 checksum of payload, the first record is header
+template<typename T>
+static void Put(std::string& buff, T val)
+{
+    buff.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+static void PutStr(std::string& buff, const std::string& str)
+{
+    Put(buff, static_cast<uint32_t>(str.size()));
+    buff += str;
+}
+
+static uint32_t Checksum(const char* data, size_t size)
+{
+    //FNV-1a
+    uint32_t hash{ 2166136261u };
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void EndRecord(std::string& buff, size_t begin)
+{
+    auto size{ static_cast<uint32_t>(buff.size() - begin - sizeof(uint32_t)) };
+    std::memcpy(buff.data() + begin, &size, sizeof(size));
+    Put(buff, Checksum(buff.data() + begin + sizeof(uint32_t), size));
+}
+
+//reader of records from journal data
+class RecordReader
+{
+    const std::string&  m_data;
+    size_t              m_offset{};
+    size_t              m_end{};
+
+public:
+    explicit RecordReader(const std::string& data) : m_data{ data } {}
+
+    bool Next()
+    {
+        uint32_t size{};
+        m_offset = m_end;
+        if (!Get(size) || m_data.size() - m_offset < static_cast<size_t>(size) + sizeof(uint32_t))
+            return false;
+
+        uint32_t sum{};
+        std::memcpy(&sum, m_data.data() + m_offset + size, sizeof(sum));
+        m_end = m_offset + size + sizeof(sum);
+        return sum == Checksum(m_data.data() + m_offset, size);
+    }
+
+    template<typename T>
+    bool Get(T& val)
+    {
+        if (m_data.size() - m_offset < sizeof(val))
+            return false;
+        std::memcpy(&val, m_data.data() + m_offset, sizeof(val));
+        m_offset += sizeof(val);
+        return true;
+    }
+
+    bool GetStr(std::string& str, size_t size)
+    {
+        if (m_data.size() - m_offset < size)
+            return false;
+        str.assign(m_data, m_offset, size);
+        m_offset += size;
+        return true;
+    }
+
+    bool GetStr(std::string& str)
+    {
+        uint32_t size{};
+        return Get(size) && GetStr(str, size);
+    }
+
+    bool GetStr(std::u16string& str, size_t size)
+    {
+        if ((m_data.size() - m_offset) / sizeof(char16_t) < size)
+            return false;
+        str.resize(size);
+        std::memcpy(str.data(), m_data.data() + m_offset, size * sizeof(char16_t));
+        m_offset += size * sizeof(char16_t);
+        return true;
+    }
+};
+
+bool EditJournal::IsLocked(const std::filesystem::path& path)
+{
+#ifdef WIN32
+    HANDLE hFile = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, 0, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return GetLastError() == ERROR_SHARING_VIOLATION;
+    CloseHandle(hFile);
+    return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    bool locked{ flock(fd, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK };
+    close(fd);
+    return locked;
+#endif
+}
+
+bool EditJournal::Read(const std::filesystem::path& path, Header& header, std::vector<EditCmd>* cmds)
+{
+    std::ifstream file{ path, std::ios::binary };
+    std::error_code ec;
+    auto size{ std::filesystem::file_size(path, ec) };
+    if (!file || ec)
+        return false;
+
+    std::string data(static_cast<size_t>(size), 0);
+    if (!file.read(data.data(), data.size()))
+        return false;
+
+    RecordReader reader{ data };
+    std::string magic;
+    uint32_t version{};
+    if (!reader.Next() || !reader.GetStr(magic, c_magic.size()) || magic != c_magic
+        || !reader.Get(version) || version != c_version
+        || !reader.GetStr(header.filePath) || !reader.Get(header.fileSize) || !reader.Get(header.fileTime)
+        || !reader.GetStr(header.cp) || !reader.GetStr(header.parseStyle))
+    {
+        LOG(DEBUG) << __FUNC__ << " bad header " << path.u8string();
+        return false;
+    }
+
+    if (!cmds)
+        return true;
+
+    //the last record can be broken by crash while writing
+    while (reader.Next())
+    {
+        EditCmd cmd;
+        uint8_t command{};
+        uint64_t line{}, pos{}, count{}, len{};
+        uint32_t strlen{};
+        if (!reader.Get(command) || !reader.Get(line) || !reader.Get(pos) || !reader.Get(count) || !reader.Get(len)
+            || !reader.Get(strlen) || !reader.GetStr(cmd.str, strlen)
+            || command < static_cast<uint8_t>(cmd_t::CMD_ADD_LINE) || command >= static_cast<uint8_t>(cmd_t::CMD_MARK))
+            break;
+
+        cmd.command = static_cast<cmd_t>(command);
+        cmd.line = static_cast<size_t>(line);
+        cmd.pos = static_cast<size_t>(pos);
+        cmd.count = static_cast<size_t>(count);
+        cmd.len = static_cast<size_t>(len);
+        cmds->push_back(std::move(cmd));
+    }
+
+    return true;
+}
+
+bool EditJournal::Create(const std::filesystem::path& path, const Header& header)
+{
+    //journal is truncated only after locking, so journal of other instance is not broken
+#ifdef WIN32
+    HANDLE hFile = CreateFileW(path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ,
+        NULL, OPEN_ALWAYS, 0, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        LOG(ERROR) << __FUNC__ << " open error=" << GetLastError() << " path=" << path.u8string();
+        return false;
+    }
+    SetEndOfFile(hFile);
+    m_file = hFile;
+#else
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        LOG(ERROR) << __FUNC__ << " open error=" << errno << " path=" << path.u8string();
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0 || ftruncate(fd, 0) != 0)
+    {
+        LOG(ERROR) << __FUNC__ << " lock error=" << errno << " path=" << path.u8string();
+        close(fd);
+        return false;
+    }
+    m_file = fd;
+#endif
+
+    m_path = path;
+    std::string buff;
+    Put(buff, uint32_t{});
+    buff += c_magic;
+    Put(buff, c_version);
+    PutStr(buff, header.filePath);
+    Put(buff, header.fileSize);
+    Put(buff, header.fileTime);
+    PutStr(buff, header.cp);
+    PutStr(buff, header.parseStyle);
+    EndRecord(buff, 0);
+
+    return Write(buff);
+}
+
+bool EditJournal::Open(const std::filesystem::path& path, const Header& header)
+{
+    Close();
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (!Create(path, header))
+    {
+        Close();
+        return false;
+    }
+
+    LOG(DEBUG) << __FUNC__ << " " << path.u8string() << " file=" << header.filePath;
+    return true;
+}
+
+void EditJournal::Close(bool remove)
+{
+    if (!IsOpen())
+        return;
+
+    if (!remove)
+        Flush();
+    m_pending.clear();
+    Unmark();
+
+#ifdef WIN32
+    CloseHandle(m_file);
+    m_file = nullptr;
+#else
+    close(m_file);
+    m_file = -1;
+#endif
+
+    if (remove)
+    {
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+    m_path.clear();
+}
+
+bool EditJournal::Write(const std::string& data)
+{
+    size_t written{};
+    while (written < data.size())
+    {
+#ifdef WIN32
+        DWORD part{};
+        if (!WriteFile(m_file, data.data() + written, static_cast<DWORD>(data.size() - written), &part, NULL) || part == 0)
+        {
+            LOG(ERROR) << __FUNC__ << " write error=" << GetLastError();
+            return false;
+        }
+#else
+        auto part = write(m_file, data.data() + written, data.size() - written);
+        if (part < 0 && errno == EINTR)
+            continue;
+        if (part <= 0)
+        {
+            LOG(ERROR) << __FUNC__ << " write error=" << errno;
+            return false;
+        }
+#endif
+        written += static_cast<size_t>(part);
+    }
+
+    return true;
+}
+
+void EditJournal::Add(cmd_t command, size_t line, size_t pos, size_t count, size_t len, const std::u16string& str)
+{
+    //only changing commands are replayed
+    if (!IsOpen() || command < cmd_t::CMD_ADD_LINE || command >= cmd_t::CMD_MARK)
+        return;
+
+    auto strlen{ std::min(str.size(), len) };
+    auto begin{ m_pending.size() };
+    Put(m_pending, uint32_t{});
+    Put(m_pending, static_cast<uint8_t>(command));
+    Put(m_pending, static_cast<uint64_t>(line));
+    Put(m_pending, static_cast<uint64_t>(pos));
+    Put(m_pending, static_cast<uint64_t>(count));
+    Put(m_pending, static_cast<uint64_t>(len));
+    Put(m_pending, static_cast<uint32_t>(strlen));
+    m_pending.append(reinterpret_cast<const char*>(str.data()), strlen * sizeof(char16_t));
+    EndRecord(m_pending, begin);
+
+    if (m_mark)
+        m_marked.append(m_pending, begin, std::string::npos);
+    if (m_pending.size() >= c_flushSize)
+        Flush();
+}
+
+bool EditJournal::Flush()
+{
+    if (!IsOpen() || m_pending.empty())
+        return true;
+
+    bool rc = Write(m_pending);
+    m_pending.clear();
+
+#ifdef WIN32
+    rc = FlushFileBuffers(m_file) && rc;
+#elif defined(__APPLE__)
+    rc = fsync(m_file) == 0 && rc;
+#else
+    rc = fdatasync(m_file) == 0 && rc;
+#endif
+    return rc;
+}
+
+bool EditJournal::Rebase(const Header& header)
+{
+    if (!IsOpen())
+        return false;
+
+    //not written commands are the tail of marked ones
+    std::string marked;
+    marked.swap(m_marked);
+    m_pending.clear();
+    auto path{ m_path };
+    if (marked.empty())
+    {
+        //file was saved without later changes
+        Close(true);
+        return true;
+    }
+
+    Close();
+    if (!Create(path, header))
+    {
+        Close();
+        return false;
+    }
+
+    m_pending.swap(marked);
+    return Flush();
+}
+
+} //namespace _Editor
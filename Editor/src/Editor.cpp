@@ -29,19 +29,30 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils/logger.h"
 #include "utils/SymbolType.h"
 #include "utils/CpConverter.h"
+#include "utils/StrScan.h"
+#include "utils/AsyncReader.h"
+#include "utils/AtomicFile.h"
 #include "utfcpp/utf8.h"
 #include "EditorApp.h"
+#include "Config.h"
+#include "Version.h"
 
 #include <thread>
+#include <chrono>
 #include <condition_variable>
-
-//#define SINGLE_THREAD
+#include <algorithm>
+#ifndef WIN32
+    #include <sys/stat.h>
+#endif
 
 namespace _Editor
 {
 
 class CoReadFile
 {
+    static constexpr size_t c_readAhead{ 4 };   //chunks queued for reading
+    static constexpr size_t c_readThreads{ 2 };
+
     std::thread                     m_thread;
     std::condition_variable         m_condition;
     std::condition_variable         m_conditionBufferReady;
@@ -56,38 +67,29 @@ class CoReadFile
     bool                                    m_toUpper{};
     std::shared_ptr<iconvpp::CpConverter>   m_converter;
 
-    std::shared_ptr<read_buff_t>    m_buff1{ std::make_shared<read_buff_t>() };
-    std::shared_ptr<read_buff_t>    m_buff2{ std::make_shared<read_buff_t>() };
     std::shared_ptr<std::u16string> m_u16buff1{ std::make_shared<std::u16string>() };
     std::shared_ptr<std::u16string> m_u16buff2{ std::make_shared<std::u16string>() };
 
     void Read(const std::filesystem::path& path)
     {
-        std::ifstream file{ path, std::ios::binary };
-
-        auto readFile = [&file](std::shared_ptr<read_buff_t> buff) -> size_t {
-            if (file.eof())
-                return 0;
+        //next chunks are read while previous one is converted and scanned
+        AsyncReader reader{ c_readThreads };
+        uint64_t offset{};
+        if (reader.Open(path, true))
+            for (size_t n = 0; n < c_readAhead; ++n, offset += c_buffsize)
+                reader.Queue(offset, c_buffsize);
 
-            file.read(buff->data(), c_buffsize);
-            auto read = file.gcount();
-            if (0 == read)
-                return 0;
-
-            return static_cast<size_t>(read);
-        };
-
-        auto ConvertCp = [this](size_t read) {
+        auto ConvertCp = [this](std::string_view data) {
             if (!m_cp)
                 return;
             if(1)//*m_cp != "UTF-8")//???
             {
-                [[maybe_unused]] bool rc = m_converter->Convert(std::string_view(m_buff1->data(), read), *m_u16buff1);
+                [[maybe_unused]] bool rc = m_converter->Convert(data, *m_u16buff1);
             }
             else
             {
-                m_u16buff1->resize(read);
-                auto it = utf8::utf8to16(m_buff1->cbegin(), m_buff1->cbegin() + read, m_u16buff1->begin());
+                m_u16buff1->resize(data.size());
+                auto it = utf8::utf8to16(data.cbegin(), data.cend(), m_u16buff1->begin());
                 m_u16buff1->erase(it, m_u16buff1->end());
             }
             
@@ -98,10 +100,18 @@ class CoReadFile
             );
         };
 
+        std::shared_ptr<std::string> buff;
+        uint64_t done{};
         size_t read;
-        while (0 != (read = readFile(m_buff1)))
+        while (0 != (read = reader.Wait(buff)))
         {
-            ConvertCp(read);
+            if (offset < reader.GetSize())
+            {
+                reader.Queue(offset, c_buffsize);
+                offset += c_buffsize;
+            }
+            done += read;
+            ConvertCp(*buff);
 
             std::unique_lock lock{ m_mutex };
             m_conditionBufferReady.wait(lock, [this]() -> bool {return !m_bufferReady || m_cancel; });
@@ -109,11 +119,10 @@ class CoReadFile
             if (m_cancel)
                 return;
 
-            std::swap(m_buff1, m_buff2);
             std::swap(m_u16buff1, m_u16buff2);
             m_bufferReady = true;
             m_read = read;
-            m_eof = file.eof();
+            m_eof = done >= reader.GetSize();
 
             m_condition.notify_one();
         }
@@ -145,15 +154,6 @@ public:
             m_thread.join();
     }
 
-    std::tuple<size_t, std::shared_ptr<read_buff_t>, bool> Wait()
-    {
-        std::unique_lock lock{ m_mutex };
-        if (!m_condition.wait_for(lock, 10s, [this]() -> bool {return m_bufferReady;}))
-            throw std::runtime_error{"Wait read ready timeout"};
-
-        return { m_read, m_buff2, m_eof };
-    }
-
     std::tuple<size_t, std::shared_ptr<std::u16string>, bool> WaitU16()
     {
         std::unique_lock lock{ m_mutex };
@@ -177,8 +177,21 @@ public:
 };
 
 
+Editor::~Editor()
+{
+    WaitSave();
+    StopIndex();
+    WaitIndexSave();
+    StopLex();
+    Unwatch();
+    //journal is removed after saving or discarding of changes, else it stays for recovery
+    m_journal.Close(!IsChanged());
+}
+
 bool Editor::SetCP(const std::string& cp) 
 {
+    //tabulation is expanded by code page
+    m_improveAll |= !m_cp.empty() && m_cp != (cp.empty() ? "UTF-8" : cp);
     m_cp = cp.empty() ? "UTF-8" : cp; 
     try
     {
@@ -196,18 +209,59 @@ bool Editor::SetCP(const std::string& cp)
 
 bool Editor::Clear()
 {
+    WaitSave();
+    StopIndex();
+    StopLex();
+    m_journal.Close(!IsChanged());
+    m_journalOff = false;
     m_buffer.Clear();
+    m_pieces.Clear();
+    m_mapFile.Close();
+    m_reader.Close();
     m_undoList.Clear();
     m_lexParser.Clear();
     m_curStrBuff.clear();
     m_curStr = STR_NOTDEFINED;
     m_curChanged = false;
+    m_improveAll = false;
+    m_changeTime = 0;
 
     return true;
 }
 
+//not modified blocks are read from mapped file or by positioned reads if file can't be mapped
+bool Editor::OpenFile()
+{
+    m_reader.Close();
+    return m_mapFile.Open(m_file) || m_reader.Open(m_file);
+}
+
 bool Editor::LoadBuff(uint64_t offset, size_t size, std::shared_ptr<std::string> buff)
 {
+    if (auto view = m_mapFile.GetView(offset, size); !view.empty())
+    {
+        buff->assign(view);
+        //neighbour blocks are read ahead for scrolling
+        m_mapFile.Prefetch(offset + size, size);
+        if (offset >= size)
+            m_mapFile.Prefetch(offset - size, size);
+        return true;
+    }
+
+    if (m_reader.IsOpen())
+    {
+        buff->resize(size);
+        if (m_reader.Read(offset, size, buff->data()) != size)
+        {
+            _assert(0);
+            return false;
+        }
+        m_reader.Prefetch(offset + size, size);
+        if (offset >= size)
+            m_reader.Prefetch(offset - size, size);
+        return true;
+    }
+
     std::ifstream file{ m_file, std::ios::binary };
     if (!file)
     {
@@ -229,6 +283,29 @@ bool Editor::LoadBuff(uint64_t offset, size_t size, std::shared_ptr<std::string>
     return true;
 }
 
+//big blocks give less block descriptors and bigger reads for huge files,
+//small blocks are faster for editing
+static size_t GetBlockSize(uintmax_t fileSize)
+{
+    size_t size{ BUFF_SIZE };
+    while (size < MAX_BUFF_SIZE && fileSize / size > c_blocksPerFile)
+        size *= 2;
+    return size;
+}
+
+//file identity for index cache and log rotation, path, size and time are checked too
+static uint64_t GetFileId([[maybe_unused]] const std::filesystem::path& file)
+{
+#ifdef WIN32
+    return 0;
+#else
+    struct stat st;
+    if (0 != stat(file.c_str(), &st))
+        return 0;
+    return static_cast<uint64_t>(st.st_ino);
+#endif
+}
+
 bool Editor::Load(bool log)
 {
     try
@@ -245,243 +322,1204 @@ bool Editor::Load(bool log)
 
     m_fileTime = std::filesystem::last_write_time(m_file);
     m_fileSize = std::filesystem::file_size(m_file);
+    m_fileId = GetFileId(m_file);
+    Watch();
 
-    LOG(DEBUG) << __FUNC__ << " path=" << m_file.u8string() << " size=" << m_fileSize;
+    m_buffer.SetBlockSize(GetBlockSize(m_fileSize));
+    LOG(DEBUG) << __FUNC__ << " path=" << m_file.u8string() << " size=" << m_fileSize << " block=" << m_buffer.GetBlockSize();
     if (0 == m_fileSize)
         return true;
 
     m_buffer.SetLoadBuffFunc(std::bind(&Editor::LoadBuff, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    if (OpenFile() && m_mapFile.IsOpen())
+        m_buffer.SetMapBuffFunc(std::bind(&MappedFile::GetView, &m_mapFile, std::placeholders::_1, std::placeholders::_2));
     if (m_fileSize > MAX_PARSED_SIZE)
         m_lexParser.EnableParsing(false);
 
+    if (!m_usePieces && g_editorConfig.pieceTableSize)
+        m_usePieces = m_fileSize >= static_cast<uintmax_t>(g_editorConfig.pieceTableSize) << 20;
+    if (m_usePieces && !m_mapFile.IsOpen())
+        //piece table works only over mapped file
+        m_usePieces = false;
+
     EditorApp::SetHelpLine("Wait for file loading");
+    if (m_usePieces)
+        return LoadPieces();
+
+    //lexical scan goes in own thread after indexing
+    if (m_mapFile.IsOpen() && m_lexParser.IsParsing())
+        StartLex(m_mapFile.GetView(0, m_mapFile.GetSize()));
+
+    if (LoadIndex())
+    {
+        EditorApp::SetHelpLine("Ready", stat_color::grayed);
+        return true;
+    }
+
+    //strings can be indexed in any order, lexical scan gets blocks in file order
+    if (g_editorConfig.progressiveLoadSize && m_fileSize >= static_cast<uintmax_t>(g_editorConfig.progressiveLoadSize) << 20
+        && m_mapFile.IsOpen())
+        return LoadProgressive();
+
+    size_t threads{ g_editorConfig.loadThreads ? g_editorConfig.loadThreads : std::thread::hardware_concurrency() };
+    threads = std::min(threads, static_cast<size_t>(m_fileSize / c_loadChunkSize));
+    if (threads > 1 && m_mapFile.IsOpen())
+        return LoadParallel(threads);
+
+    time_t start{ time(nullptr) };
+    auto loadStart{ std::chrono::steady_clock::now() };
+
+    bool rc;
+    if (m_mapFile.IsOpen())
+    {
+        //strings are indexed right in mapped file, not modified blocks are read from it on demand
+        time_t t1{ time(nullptr) };
+        auto data = m_mapFile.GetView(0, m_mapFile.GetSize());
+        if (m_cp == "UTF-8" && data.substr(0, 3) == c_utf8Bom)
+            m_bom = true;
+
+        rc = IndexPart(data, 0, data.size(), [this, &t1, &data](strbuff_ptr strBuff) {
+            m_buffer.AppendBuff(strBuff);
+            LexBuff(strBuff);
+
+            time_t t2{ time(nullptr) };
+            if (t1 != t2)
+            {
+                t1 = t2;
+                EditorApp::ShowProgressBar(static_cast<size_t>((strBuff->m_fileOffset + strBuff->GetBuffSize()) * 100 / data.size()));
+            }
+            return true;
+        });
+    }
+    else
+    {
+        std::ifstream file{ m_file, std::ios::binary };
+        rc = file && ReadBlocks(file, 0);
+    }
+    EndLex();
 
+    if (!rc)
+    {
+        _assert(0);
+        return false;
+    }
+
+    _assert(!log || m_fileSize == GetSize());
+    
+    EditorApp::ShowProgressBar();
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
+
+    auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count();
+    LOG(DEBUG) << "load time=" << time(NULL) - start << " speed=" << (m_fileSize >> 10) / (loadTime + 1) << "MB/s scan=" << StrScan::GetImpl();
+    LOG(DEBUG) << "num str=" << GetStrCount();
+
+    auto stat{ BuffPool<std::string>::s_pool.GetStat() };
+    LOG(DEBUG) << "pool blocks=" << stat.allocated << " hits=" << stat.hits << " misses=" << stat.misses << " evictions=" << stat.evictions
+        << " spills=" << stat.spills << " restores=" << stat.restores
+        << " packs=" << stat.packs << " unpacks=" << stat.unpacks << " packed=" << stat.packedSize;
+    LogMemStat();
+    SaveIndex();
+
+    return true;
+}
+
+void Editor::LogMemStat() const
+{
+    auto stat{ GetMemStat() };
+    LOG(INFO) << "memory " << m_file.filename().u8string() << ": blocks=" << stat.blocks << " strings=" << stat.strings
+        << " text=" << stat.dataSize << " pool=" << stat.poolSize << " offsets=" << stat.offsetSize
+        << " descriptors=" << stat.infoSize << " wide blocks=" << stat.wideBlocks << (m_usePieces ? " piece table" : "");
+}
+
+bool Editor::LoadPieces(uint64_t offset)
+{
     time_t start{ time(nullptr) };
     time_t t1{ time(nullptr) };
     size_t percent{};
-    auto step{ m_fileSize / 100 };//1%
 
-    size_t buffOffset{0};
-    uintmax_t fileOffset{};
-    std::shared_ptr<StrBuff<std::string, std::string_view>> strBuff;
-    size_t strOffset{};
+    auto data = m_mapFile.GetView(0, m_mapFile.GetSize());
+    m_pieces.SetOriginal(data);
+    auto step{ (data.size() - offset) / 100 };//1%
+    uint64_t begin{ offset };
 
-#ifdef SINGLE_THREAD
-    std::ifstream file{ m_file, std::ios::binary };
-    if (!file)
-        return false;
+    //scan states of the last string are kept for continuation by log tail
+    LexParser::LexState blockState;
+    size_t blockLine{};
+    while (offset < data.size())
+    {
+        size_t size = std::min(static_cast<size_t>(BUFF_SIZE), static_cast<size_t>(data.size() - offset));
+        bool last = offset + size == data.size();
 
-    auto buff{ std::make_shared<read_buff_t>() };
-    auto readFile = [&](std::shared_ptr<read_buff_t> buff) -> size_t {
-        if (file.eof())
-            return 0;
+        //scanner reads one byte after the end, so the last part is copied
+        std::string tail;
+        const char* buff = data.data() + offset;
+        if (last)
+        {
+            tail = data.substr(static_cast<size_t>(offset));
+            buff = tail.c_str();
+        }
 
-        file.read(buff->data(), c_buffsize);
-        auto read = file.gcount();
-        if (0 == read)
-            return 0;
+        uint32_t used{};
+        ScanStrOffset(buff, size, last, offset == 0, [this, buff, offset, last, &used, &blockState, &blockLine](uint32_t end) {
+            if (last)
+            {
+                blockState = m_lexParser.GetState();
+                blockLine = m_pieces.GetStrCount();
+            }
+            LexStr(m_lexParser, m_pieces.GetStrCount(), { buff + used, end - used });
+            m_pieces.AppendOriginalStr(offset + end);
+            used = end;
+        });
+        if (!used)
+        {
+            _assert(0);
+            return false;
+        }
+        offset += used;
 
         time_t t2{ time(nullptr) };
         if (t1 != t2 && step)
         {
             t1 = t2;
-            size_t pr{ static_cast<size_t>((fileOffset + read) / step) };
+            size_t pr{ static_cast<size_t>((offset - begin) / step) };
             if (pr != percent)
             {
                 percent = pr;
                 EditorApp::ShowProgressBar(pr);
             }
         }
-        return static_cast<size_t>(read);
-    };
+    }
 
-    size_t read;
-    while (0 != (read = readFile(buff)))
     {
-        buffOffset = 0;
-        bool rc = ApplyBuffer(buff, read, buffOffset,
-            strBuff, strOffset,
-            fileOffset, file.eof());
-        if (!rc)
-            return false;
+        std::lock_guard lock{ m_lexMutex };
+        m_lexBlockState = std::move(blockState);
+        m_lexBlockLine = blockLine;
+        m_lexEndState = m_lexParser.GetState();
+        m_lexEndLine = GetStrCount();
     }
-#else
-    CoReadFile rfile(m_file, std::nullopt);
 
-    try
+    EditorApp::ShowProgressBar();
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
+
+    LOG(DEBUG) << "load time=" << time(NULL) - start;
+    LOG(DEBUG) << "num str=" << GetStrCount();
+    LogMemStat();
+
+    return true;
+}
+
+bool Editor::LoadParallel(size_t threads)
+{
+    auto loadStart{ std::chrono::steady_clock::now() };
+    auto data = m_mapFile.GetView(0, m_mapFile.GetSize());
+
+    if (m_cp == "UTF-8" && data.substr(0, 3) == c_utf8Bom)
+        m_bom = true;
+
+    std::vector<std::vector<strbuff_ptr>> parts;
+    if (!IndexParallel(data, 0, threads, parts))
     {
-        for (;;)
+        _assert(0);
+        return false;
+    }
+
+    for (auto& part : parts)
+        for (auto& strBuff : part)
         {
-            auto [read, buff, eof] = rfile.Wait();
-            if (read == 0)
-                break;
+            m_buffer.AppendBuff(strBuff);
+            LexBuff(strBuff);
+        }
+    EndLex();
 
-            buffOffset = 0;
-            bool rc = ApplyBuffer(buff, read, buffOffset,
-                strBuff, strOffset,
-                fileOffset, eof);
-            if (!rc)
-                return false;
+    EditorApp::ShowProgressBar();
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
 
-            rfile.Next();
+    auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count();
+    LOG(DEBUG) << "parallel load threads=" << parts.size() << " time=" << loadTime << "ms speed=" << (m_fileSize >> 10) / (loadTime + 1) << "MB/s";
+    LOG(DEBUG) << "num str=" << GetStrCount();
+    LogMemStat();
+    SaveIndex();
+
+    return true;
+}
+
+bool Editor::IndexParallel(std::string_view data, uint64_t offset, size_t threads, std::vector<std::vector<strbuff_ptr>>& parts)
+{
+    time_t t1{ time(nullptr) };
+
+    //every part begins after LF, so strings are the same as in sequential loading
+    std::vector<uint64_t> bounds{ offset };
+    for (size_t n = 1; n < threads; ++n)
+    {
+        size_t pos = std::max(static_cast<size_t>(bounds.back()), static_cast<size_t>(offset + (data.size() - offset) / threads * n));
+        auto lf = data.find(S_LF, pos);
+        if (lf == std::string_view::npos || lf + 1 >= data.size())
+            break;
+        bounds.push_back(lf + 1);
+    }
+    bounds.push_back(data.size());
+
+    parts.clear();
+    parts.resize(bounds.size() - 1);
+    std::atomic_bool error{};
+
+    auto index = [&](size_t n) {
+        uint64_t end{ bounds[n + 1] };
+        bool rc = IndexPart(data, bounds[n], end, [&](strbuff_ptr strBuff) {
+            parts[n].push_back(strBuff);
 
             time_t t2{ time(nullptr) };
-            if (t1 != t2 && step)
+            if (n == 0 && t1 != t2)
             {
+                //progress of the first part only, others go at the same speed
                 t1 = t2;
-                size_t pr{ static_cast<size_t>((fileOffset + read) / step) };
-                if (pr != percent)
-                {
-                    percent = pr;
-                    EditorApp::ShowProgressBar(pr);
-                }
+                EditorApp::ShowProgressBar(static_cast<size_t>((strBuff->m_fileOffset + strBuff->GetBuffSize() - offset) * 100 / (end - offset)));
+            }
+            return !error;
+        });
+        if (!rc)
+            error = true;
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t n = 1; n < parts.size(); ++n)
+        workers.emplace_back(index, n);
+    index(0);
+    for (auto& worker : workers)
+        worker.join();
+
+    return !error;
+}
+
+bool Editor::IndexPart(std::string_view data, uint64_t offset, uint64_t end, const std::function<bool(strbuff_ptr)>& addBuff)
+{
+    size_t blockSize = m_buffer.GetBlockSize();
+    try
+    {
+        while (offset < end)
+        {
+            size_t size = static_cast<size_t>(std::min(static_cast<uint64_t>(blockSize), end - offset));
+            bool last = offset + size == end;
+
+            //scanner reads one byte after the end of file, so the last part is copied
+            std::string tail;
+            const char* buff = data.data() + offset;
+            if (last && end == data.size())
+            {
+                tail = data.substr(static_cast<size_t>(offset), size);
+                buff = tail.c_str();
+            }
+
+            //not modified block will be read from mapped file
+            auto strBuff = std::make_shared<StrBuff<std::string, std::string_view>>(blockSize);
+            strBuff->m_fileOffset = offset;
+            strBuff->m_lostData = true;
+            ScanStrOffset(buff, size, last, offset == 0,
+                [&strBuff](uint32_t strEnd) { strBuff->m_strOffsetList.push_back(strEnd); });
+            if (strBuff->m_strOffsetList.empty())
+            {
+                _assert(0);
+                return false;
             }
+            strBuff->m_strOffsetList.shrink_to_fit();
+            offset += strBuff->GetBuffSize();
+            if (!addBuff(strBuff))
+                return false;
         }
     }
     catch (...)
     {
-        _assert(0);
         return false;
     }
-#endif
-
-    _assert(!log || m_fileSize == fileOffset);
-    
-    EditorApp::ShowProgressBar();
-    EditorApp::SetHelpLine("Ready", stat_color::grayed);
-
-    LOG(DEBUG) << "load time=" << time(NULL) - start;
-    LOG(DEBUG) << "num str=" << m_buffer.m_totalStrCount;
 
     return true;
 }
 
-bool Editor::LoadTail()
+bool Editor::LoadProgressive()
 {
-    std::ifstream file{ m_file, std::ios::binary };
-    if (!file)
+    auto loadStart{ std::chrono::steady_clock::now() };
+    auto data = m_mapFile.GetView(0, m_mapFile.GetSize());
+
+    if (m_cp == "UTF-8" && data.substr(0, 3) == c_utf8Bom)
+        m_bom = true;
+
+    //the first part is indexed at once for showing of the first screen
+    uint64_t end{ data.size() };
+    if (auto lf = data.find(S_LF, c_loadChunkSize); lf != std::string_view::npos && lf + 1 < data.size())
+        end = lf + 1;
+
+    bool rc = IndexPart(data, 0, end, [this](strbuff_ptr strBuff) { LexBuff(strBuff); return m_buffer.AppendBuff(strBuff); });
+    if (!rc)
     {
         _assert(0);
         return false;
     }
 
-    m_fileTime = std::filesystem::last_write_time(m_file);
-    m_fileSize = std::filesystem::file_size(m_file);
+    auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count();
+    LOG(DEBUG) << "progressive load first part=" << end << " time=" << loadTime << "ms num str=" << GetStrCount();
 
-    auto buff{ std::make_shared<read_buff_t>() };
-    size_t buffOffset{ 0 };
+    if (end < data.size())
+        rc = StartIndex(data, end);
+    if (!m_indexing)
+        EndLex();
 
-    std::shared_ptr<StrBuff<std::string, std::string_view>> strBuff = m_buffer.m_buffList.back();
-    strBuff->m_lostData = false;
-    m_buffer.m_totalStrCount -= strBuff->GetStrCount();
-    strBuff->m_strOffsetList.clear();
-    size_t strOffset{};
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
+    return rc;
+}
 
-    uintmax_t fileOffset{strBuff->m_fileOffset};
-    size_t toRead{ std::min(c_buffsize, static_cast<size_t>(m_fileSize - fileOffset)) };
-    //LOG(DEBUG) << __FUNC__ << " path=" << m_file.u8string() << " offset=" << fileOffset << " read=" << toRead;
+bool Editor::StartIndex(std::string_view data, uint64_t offset)
+{
+    StopIndex();
 
-    file.seekg(fileOffset);
-    file.read(buff->data(), std::min(c_buffsize, toRead));
-    _assert(file.good());
-    auto read = file.gcount();
-    m_fileSize = fileOffset + read;
-    
-    bool rc = ApplyBuffer(buff, read, buffOffset,
-        strBuff, strOffset,
-        fileOffset, true);
+    m_indexOffset = offset;
+    m_indexing = true;
+    try
+    {
+        m_indexThread = std::thread([this, data, offset]() {
+            auto start{ std::chrono::steady_clock::now() };
+            bool rc = IndexPart(data, offset, data.size(), [this](strbuff_ptr strBuff) {
+                {
+                    std::lock_guard lock{ m_indexMutex };
+                    m_indexed.push_back(strBuff);
+                }
+                m_indexOffset = strBuff->m_fileOffset + strBuff->GetBuffSize();
+                m_indexCond.notify_one();
+                return !m_indexCancel;
+            });
 
-    return rc;
+            auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            LOG(DEBUG) << "background index time=" << time << "ms rc=" << rc;
+
+            std::lock_guard lock{ m_indexMutex };
+            m_indexDone = true;
+            m_indexError = !rc && !m_indexCancel;
+            m_indexCond.notify_one();
+        });
+    }
+    catch (...)
+    {
+        _assert(0);
+        m_indexing = false;
+        return false;
+    }
+
+    return true;
 }
 
-bool Editor::ApplyBuffer(const std::shared_ptr<read_buff_t>& buff, size_t read, size_t& buffOffset,
-    std::shared_ptr<StrBuff<std::string, std::string_view>>& strBuff, size_t& strOffset,
-    uintmax_t& fileOffset, bool eof)
+void Editor::StopIndex()
 {
-    if (fileOffset == 0)
+    m_indexCancel = true;
+    if (m_indexThread.joinable())
+        m_indexThread.join();
+
+    m_indexed.clear();
+    m_indexCancel = false;
+    m_indexDone = false;
+    m_indexError = false;
+    m_indexing = false;
+}
+
+bool Editor::UpdateIndex()
+{
+    if (!m_indexing)
+        return false;
+
+    std::vector<strbuff_ptr> ready;
+    bool done;
+    bool error;
     {
-        if (m_cp == "UTF-8" && buff->size() >= 3)
-        {
-            std::string bom{buff->data(), 3};
-            if (bom == c_utf8Bom)
-                m_bom = true;
-        }
+        std::lock_guard lock{ m_indexMutex };
+        ready.swap(m_indexed);
+        done = m_indexDone;
+        error = m_indexError;
     }
 
-    while (read)
+    //blocks are added after the last string that is known to editor
+    for (auto& strBuff : ready)
     {
-        if (!strBuff)
-        {
-            strBuff = m_buffer.GetNewBuff();
-            strOffset = 0;
-        }
-        auto strBuffData{ strBuff->GetBuff() };
-        if (!strBuffData)
+        m_buffer.AppendBuff(strBuff);
+        LexBuff(strBuff);
+    }
+
+    if (done)
+    {
+        m_indexThread.join();
+        EndLex();
+        m_indexDone = false;
+        m_indexing = false;
+        if (error)
         {
-            //no memory
             _assert(0);
-            return false;
+            EditorApp::SetErrorLine("File indexing error");
         }
-        size_t tocopy{ std::min(static_cast<size_t>(BUFF_SIZE) - strOffset, read) };
-        strBuffData->resize(strOffset + tocopy);
-        std::memcpy(strBuffData->data() + strOffset, buff->data() + buffOffset, tocopy);
-        strBuff->ReleaseBuff();
-
-        if (strOffset + tocopy < BUFF_SIZE / 2 && !eof)
-            strOffset += tocopy;
-        else
-        {
-            //now fill string offset table
-            strBuff->m_fileOffset = fileOffset;
+        LOG(DEBUG) << "indexing finished num str=" << GetStrCount();
+        LogMemStat();
+        if (!error)
+            SaveIndex();
+    }
 
-            size_t rest;
-            //LOG(DEBUG) << std::hex << "file offset=" << fileOffset << " read=" << read << " strOffset=" << strOffset << " tocopy=" << tocopy << std:: dec;
-            [[maybe_unused]] bool rc = FillStrOffset(strBuff, strOffset + tocopy, m_fileSize <= fileOffset + strOffset + tocopy, rest);
-            //LOG(DEBUG) << std::hex << "rest=" << rest << std::dec;
+    return !ready.empty();
+}
 
-            _assert(rc);
-            if (tocopy > rest)
-                tocopy -= rest;
-            else
-            {
-                _assert(0);
-            }
+bool Editor::WaitIndex(size_t line)
+{
+    if (!m_indexing || (line != STR_NOTDEFINED && line < GetStrCount()))
+        return true;
 
-            fileOffset += tocopy + strOffset;
-            m_buffer.m_totalStrCount += strBuff->GetStrCount();
-            strBuff = nullptr;
-            strOffset = 0;
+    EditorApp::SetHelpLine("Wait for file indexing");
+    time_t t1{ time(nullptr) };
+    while (m_indexing && (line == STR_NOTDEFINED || line >= GetStrCount()))
+    {
+        {
+            std::unique_lock lock{ m_indexMutex };
+            m_indexCond.wait_for(lock, std::chrono::milliseconds(100), [this] { return !m_indexed.empty() || m_indexDone; });
         }
+        UpdateIndex();
 
-        buffOffset += tocopy;
-        read -= tocopy;
+        time_t t2{ time(nullptr) };
+        if (t1 != t2 && m_fileSize)
+        {
+            t1 = t2;
+            EditorApp::ShowProgressBar(static_cast<size_t>(m_indexOffset * 100 / m_fileSize));
+        }
     }
 
+    EditorApp::ShowProgressBar();
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
     return true;
 }
 
-bool Editor::FillStrOffset(std::shared_ptr<StrBuff<std::string, std::string_view>> strBuff, size_t size, bool last, size_t& rest)
+//string is scanned without eol like in editing
+void Editor::LexStr(LexParser& lexer, size_t line, std::string_view str) const
 {
-    auto str{ strBuff->GetBuff() };
-    if (!str)
-        return false;
+    if (!str.empty() && str.back() == S_LF)
+        str.remove_suffix(1);
+    if (!str.empty() && str.back() == S_CR)
+        str.remove_suffix(1);
+    lexer.ScanStr(line, str, m_cp);
+}
 
-    //1 byte is reserved for 0xA so 0D and 0A EOL will go to same buffers
-    //and we not get left empty string
-    const size_t maxsize{ !last ? size - 1 : size };
-    const size_t maxtab{ 10 };
-    size_t cr{};
-    size_t crlf{};
-    size_t lf{};
-    size_t cut{};
-    size_t len{};
+bool Editor::StartLex(std::string_view data, size_t line, const LexParser::LexState& state)
+{
+    StopLex();
 
-    size_t begin{};
-    size_t i;
-    const char* buff {str->c_str()};
+    m_lexData = data;
+    return RunLex(line, state);
+}
 
-    for (i = 0; i < maxsize; ++i)
+bool Editor::RunLex(size_t line, const LexParser::LexState& state)
+{
+    m_lexMerged = line;
+    m_lexLine = line;
+    m_lexEndState = state;
+    m_lexEndLine = line;
+    m_lexing = true;
+    try
     {
+        //own parser keeps scan state, results are merged by UI thread
+        LexParser lexer;
+        lexer.SetParseStyle(m_lexParser.GetParseStyle());
+        lexer.SetState(state);
+        m_lexThread = std::thread([this, data = m_lexData, line, lexer = std::move(lexer)]() mutable {
+            auto start{ std::chrono::steady_clock::now() };
+            for (;;)
+            {
+                strbuff_ptr strBuff;
+                {
+                    std::unique_lock lock{ m_lexMutex };
+                    m_lexCond.wait(lock, [this] { return !m_lexQueue.empty() || m_lexQueueEnd || m_lexCancel; });
+                    if (m_lexCancel || m_lexQueue.empty())
+                        break;
+                    strBuff = m_lexQueue.front();
+                    m_lexQueue.pop_front();
+                }
+
+                //blocks are not modified while scan goes, so strings are taken from mapped file
+                const char* buff = data.data() + strBuff->m_fileOffset;
+                auto blockState{ lexer.GetState() };
+                size_t blockLine{ line };
+                uint32_t begin{};
+                for (size_t n = 0; n < strBuff->GetStrCount(); ++n)
+                {
+                    uint32_t end{ strBuff->m_strOffsetList[n] };
+                    LexStr(lexer, line++, { buff + begin, end - begin });
+                    begin = end;
+                }
+
+                std::map<size_t, std::string> lexems;
+                lexer.TakeLexems(lexems);
+                {
+                    std::lock_guard lock{ m_lexMutex };
+                    m_lexed.push_back(std::move(lexems));
+                    m_lexLine = line;
+                    m_lexBlockState = std::move(blockState);
+                    m_lexBlockLine = blockLine;
+                    m_lexEndState = lexer.GetState();
+                    m_lexEndLine = line;
+                }
+                m_lexCond.notify_all();
+            }
+
+            auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            LOG(DEBUG) << "lexical scan time=" << time << "ms lines=" << line;
+
+            std::lock_guard lock{ m_lexMutex };
+            m_lexDone = true;
+            m_lexCond.notify_all();
+        });
+    }
+    catch (...)
+    {
+        _assert(0);
+        m_lexing = false;
+        return false;
+    }
+
+    return true;
+}
+
+void Editor::LexBuff(const strbuff_ptr& strBuff)
+{
+    if (!m_lexing)
+        return;
+
+    {
+        std::lock_guard lock{ m_lexMutex };
+        m_lexQueue.push_back(strBuff);
+    }
+    m_lexCond.notify_all();
+}
+
+void Editor::EndLex()
+{
+    if (!m_lexing)
+        return;
+
+    {
+        std::lock_guard lock{ m_lexMutex };
+        m_lexQueueEnd = true;
+    }
+    m_lexCond.notify_all();
+}
+
+void Editor::StopLex()
+{
+    {
+        std::lock_guard lock{ m_lexMutex };
+        m_lexCancel = true;
+    }
+    m_lexCond.notify_all();
+    if (m_lexThread.joinable())
+        m_lexThread.join();
+
+    m_lexQueue.clear();
+    m_lexed.clear();
+    m_lexQueueEnd = false;
+    m_lexCancel = false;
+    m_lexDone = false;
+    m_lexing = false;
+}
+
+bool Editor::SuspendLex(size_t line)
+{
+    WaitLex(line);
+    if (!m_lexing)
+        return false;
+
+    //the block being scanned is finished, not scanned blocks stay in queue
+    {
+        std::lock_guard lock{ m_lexMutex };
+        m_lexCancel = true;
+    }
+    m_lexCond.notify_all();
+    m_lexThread.join();
+
+    for (auto& lexems : m_lexed)
+        m_lexParser.MergeLexems(lexems);
+    m_lexed.clear();
+    m_lexMerged = m_lexLine;
+    m_lexCancel = false;
+    m_lexDone = false;
+
+    return true;
+}
+
+bool Editor::ResumeLex(int64_t shift)
+{
+    //not scanned lines are moved by editing
+    m_lexBlockLine += shift;
+    return RunLex(m_lexLine + shift, m_lexEndState);
+}
+
+bool Editor::UpdateLex()
+{
+    if (!m_lexing)
+        return false;
+
+    std::vector<std::map<size_t, std::string>> ready;
+    bool done;
+    {
+        std::lock_guard lock{ m_lexMutex };
+        ready.swap(m_lexed);
+        done = m_lexDone;
+        m_lexMerged = m_lexLine;
+    }
+
+    for (auto& lexems : ready)
+        m_lexParser.MergeLexems(lexems);
+
+    if (done)
+    {
+        m_lexThread.join();
+        m_lexQueueEnd = false;
+        m_lexDone = false;
+        m_lexing = false;
+    }
+
+    return !ready.empty();
+}
+
+bool Editor::WaitLex(size_t line)
+{
+    time_t t1{ time(nullptr) };
+    bool progress{};
+    while (m_lexing && (line == STR_NOTDEFINED || line >= m_lexMerged))
+    {
+        {
+            std::unique_lock lock{ m_lexMutex };
+            m_lexCond.wait_for(lock, std::chrono::milliseconds(100), [this] { return !m_lexed.empty() || m_lexDone; });
+        }
+        //strings indexed in background go to lexical scan too
+        UpdateIndex();
+        UpdateLex();
+
+        time_t t2{ time(nullptr) };
+        if (t1 != t2 && GetStrCount())
+        {
+            t1 = t2;
+            if (!progress)
+            {
+                EditorApp::SetHelpLine("Wait for lexical scan");
+                progress = true;
+            }
+            EditorApp::ShowProgressBar(std::min<size_t>(99, m_lexMerged * 100 / GetStrCount()));
+        }
+    }
+
+    if (progress)
+    {
+        EditorApp::ShowProgressBar();
+        EditorApp::SetHelpLine("Ready", stat_color::grayed);
+    }
+
+    return true;
+}
+
+std::filesystem::path Editor::GetJournalDir()
+{
+    return Directory::UserCfgPath(EDITOR_NAME) / c_journalDir;
+}
+
+std::filesystem::path Editor::GetJournalPath() const
+{
+    auto path{ std::filesystem::absolute(m_file).u8string() };
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(path) << ".jrn";
+    return GetJournalDir() / name.str();
+}
+
+EditJournal::Header Editor::GetJournalHeader() const
+{
+    return { std::filesystem::absolute(m_file).u8string(), m_fileSize, m_fileTime.time_since_epoch().count(),
+        m_cp, m_lexParser.GetParseStyle() };
+}
+
+bool Editor::Recover(const std::filesystem::path& journal)
+{
+    EditJournal::Header header;
+    std::vector<EditCmd> cmds;
+    if (!EditJournal::Read(journal, header, &cmds))
+        return false;
+
+    LOG(DEBUG) << __FUNC__ << " " << journal.u8string() << " commands=" << cmds.size();
+    //replayed commands are written to new journal with the same name
+    std::error_code ec;
+    std::filesystem::remove(journal, ec);
+
+    WaitIndex();
+    for (auto& cmd : cmds)
+        Command(cmd);
+    m_journal.Flush();
+
+    return true;
+}
+
+std::filesystem::path Editor::GetIndexPath() const
+{
+    auto path{ std::filesystem::absolute(m_file).u8string() };
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(path) << ".idx";
+    return Directory::UserCfgPath(EDITOR_NAME) / c_indexCacheDir / name.str();
+}
+
+bool Editor::UseIndexCache() const
+{
+    return g_editorConfig.indexCacheSize && m_fileSize >= static_cast<uintmax_t>(g_editorConfig.indexCacheSize) << 20
+        && !m_usePieces && m_mapFile.IsOpen();
+}
+
+//cache key, index is used only for the same file and the same scan settings
+std::string Editor::GetIndexKey() const
+{
+    std::stringstream key;
+    key << c_indexCacheVer << '|' << std::filesystem::absolute(m_file).u8string() << '|' << m_fileSize
+        << '|' << m_fileTime.time_since_epoch().count() << '|' << GetFileId(m_file)
+        << '|' << m_cp << '|' << m_maxStrlen << '|' << m_buffer.GetBlockSize();
+    return key.str();
+}
+
+bool Editor::SaveIndex()
+{
+    if (!UseIndexCache() || m_buffer.IsChanged() || m_buffer.m_buffList.empty())
+        return false;
+
+    //offsets are serialized in UI thread as memory copy, file is written in background
+    auto start{ std::chrono::steady_clock::now() };
+    std::string data;
+    auto write = [&data](const auto& val) { data.append(reinterpret_cast<const char*>(&val), sizeof(val)); };
+    auto key{ GetIndexKey() };
+    write(static_cast<uint32_t>(key.size()));
+    data += key;
+    write(static_cast<uint8_t>(m_eol));
+    write(static_cast<uint8_t>(m_bom));
+    write(static_cast<uint64_t>(m_buffer.m_buffList.size()));
+
+    size_t strCount{ GetStrCount() };
+    data.reserve(data.size() + m_buffer.m_buffList.size() * (sizeof(uint64_t) + sizeof(uint32_t)) + strCount * sizeof(uint32_t));
+    for (auto& strBuff : m_buffer.m_buffList)
+    {
+        write(strBuff->m_fileOffset);
+        write(static_cast<uint32_t>(strBuff->GetStrCount()));
+        for (size_t n = 0; n < strBuff->GetStrCount(); ++n)
+            write(static_cast<uint32_t>(strBuff->m_strOffsetList[n]));
+    }
+
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG(DEBUG) << "index serialized size=" << data.size() << " time=" << time << "ms";
+
+    WaitIndexSave();
+    try
+    {
+        m_indexSaveThread = std::thread([path = GetIndexPath(), data = std::move(data)]() {
+            if (WriteIndex(path, data))
+                PruneIndexCache(path.parent_path());
+        });
+    }
+    catch (...)
+    {
+        _assert(0);
+        return false;
+    }
+
+    return true;
+}
+
+void Editor::WaitIndexSave()
+{
+    if (m_indexSaveThread.joinable())
+        m_indexSaveThread.join();
+}
+
+bool Editor::WriteIndex(const std::filesystem::path& path, const std::string& data)
+{
+    auto start{ std::chrono::steady_clock::now() };
+    try
+    {
+        std::filesystem::create_directories(path.parent_path());
+
+        //index is written to temporary file, so broken file never has valid header
+        auto tmpPath{ path };
+        tmpPath += ".tmp";
+        std::ofstream file{ tmpPath, std::ios::binary | std::ios::trunc };
+        if (!file)
+            return false;
+
+        file.write(data.data(), data.size());
+        file.close();
+        if (!file)
+        {
+            std::filesystem::remove(tmpPath);
+            return false;
+        }
+        std::filesystem::rename(tmpPath, path);
+    }
+    catch (...)
+    {
+        LOG(ERROR) << __FUNC__ << " path=" << path.u8string();
+        return false;
+    }
+
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG(DEBUG) << "index saved " << path.u8string() << " time=" << time << "ms";
+    return true;
+}
+
+void Editor::PruneIndexCache(const std::filesystem::path& dir)
+{
+    //modification time of index is updated with every using, so the oldest ones are removed
+    std::error_code ec;
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+    for (auto& entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        auto time = entry.last_write_time(ec);
+        if (!ec && entry.is_regular_file(ec))
+            files.emplace_back(time, entry.path());
+    }
+    if (files.size() <= c_indexCacheFiles)
+        return;
+
+    std::sort(files.begin(), files.end());
+    for (size_t n = 0; n < files.size() - c_indexCacheFiles; ++n)
+    {
+        LOG(DEBUG) << __FUNC__ << " remove " << files[n].second.u8string();
+        std::filesystem::remove(files[n].second, ec);
+    }
+}
+
+bool Editor::LoadIndex()
+{
+    if (!UseIndexCache())
+        return false;
+
+    auto start{ std::chrono::steady_clock::now() };
+    auto path{ GetIndexPath() };
+    std::ifstream file{ path, std::ios::binary };
+    if (!file)
+        return false;
+
+    auto read = [&file](auto& val) { return static_cast<bool>(file.read(reinterpret_cast<char*>(&val), sizeof(val))); };
+    uint32_t keySize{};
+    if (!read(keySize) || keySize > 0x10000)
+        return false;
+    std::string key(keySize, 0);
+    file.read(key.data(), keySize);
+    if (!file || key != GetIndexKey())
+    {
+        LOG(DEBUG) << "index is outdated " << path.u8string();
+        return false;
+    }
+
+    uint8_t eol{};
+    uint8_t bom{};
+    uint64_t blocks{};
+    if (!read(eol) || !read(bom) || !read(blocks) || eol > static_cast<uint8_t>(eol_t::mac_eol))
+        return false;
+
+    //blocks must cover all file without gaps, otherwise file is scanned again
+    size_t blockSize{ m_buffer.GetBlockSize() };
+    uint64_t fileOffset{};
+    std::vector<uint32_t> offsets;
+    std::list<strbuff_ptr> buffList;
+    for (uint64_t b = 0; b < blocks; ++b)
+    {
+        uint64_t offset{};
+        uint32_t count{};
+        if (!read(offset) || !read(count) || offset != fileOffset || count == 0 || count > blockSize)
+            return false;
+        offsets.resize(count);
+        if (!file.read(reinterpret_cast<char*>(offsets.data()), count * sizeof(uint32_t)) || offsets.back() > blockSize)
+            return false;
+
+        auto strBuff = std::make_shared<StrBuff<std::string, std::string_view>>(blockSize);
+        strBuff->m_fileOffset = offset;
+        strBuff->m_lostData = true;
+        uint32_t prev{};
+        for (auto end : offsets)
+        {
+            if (end < prev)
+                return false;
+            strBuff->m_strOffsetList.push_back(prev = end);
+        }
+        strBuff->m_strOffsetList.shrink_to_fit();
+        fileOffset += strBuff->GetBuffSize();
+        buffList.push_back(strBuff);
+    }
+    if (fileOffset != m_fileSize || file.peek() != std::ifstream::traits_type::eof())
+        return false;
+
+    for (auto& strBuff : buffList)
+    {
+        m_buffer.AppendBuff(strBuff);
+        LexBuff(strBuff);
+    }
+    EndLex();
+    m_eol = static_cast<eol_t>(eol);
+    m_bom = bom != 0;
+
+    //used index becomes the newest one for pruning of cache
+    file.close();
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG(DEBUG) << "index loaded " << path.u8string() << " time=" << time << "ms num str=" << GetStrCount();
+    LogMemStat();
+    return true;
+}
+
+bool Editor::LoadTail()
+{
+    WaitSave();
+    //tail is added after the last indexed block
+    WaitIndex();
+    WaitLex();
+
+    auto fileSize = std::filesystem::file_size(m_file);
+    if (fileSize < m_fileSize || GetFileId(m_file) != m_fileId || (!m_usePieces && m_buffer.m_buffList.empty())
+        || m_mapFile.IsTruncated())
+    {
+        //log was truncated or rotated
+        LOG(DEBUG) << __FUNC__ << " reload path=" << m_file.u8string() << " size=" << fileSize;
+        return Load(true);
+    }
+
+    m_fileTime = std::filesystem::last_write_time(m_file);
+    if (fileSize == m_fileSize)
+        return true;
+
+    if (m_usePieces)
+        return LoadPiecesTail();
+
+    //file was changed, map it again
+    m_buffer.ResetMapping();
+    OpenFile();
+
+    //the last block is read again if its string is not finished or if it is small,
+    //so appending by small parts doesn't make many small blocks
+    uintmax_t fileOffset{ m_fileSize };
+    auto lastIt = std::prev(m_buffer.m_buffList.end());
+    char lastCh{};
+    if (auto view = m_mapFile.GetView(m_fileSize - 1, 1); !view.empty())
+        lastCh = view[0];
+    else if (!m_reader.IsOpen() || m_reader.Read(m_fileSize - 1, 1, &lastCh) != 1)
+        lastCh = 0;
+    //lexical scan goes on from the state of first new string
+    auto lexState{ m_lexEndState };
+    if (GetStrCount() != m_lexEndLine)
+        lexState = {};
+    if (lastCh != S_LF || (*lastIt)->GetBuffSize() < m_buffer.GetBlockSize() / 2)
+    {
+        fileOffset = (*lastIt)->m_fileOffset;
+        m_buffer.m_totalStrCount -= (*lastIt)->GetStrCount();
+        m_buffer.DelBuff(lastIt);
+        lexState = GetStrCount() == m_lexBlockLine ? m_lexBlockState : LexParser::LexState{};
+    }
+    m_lexParser.Clear(GetStrCount());
+
+    auto start{ std::chrono::steady_clock::now() };
+    size_t prevStr{ GetStrCount() };
+    bool rc;
+    if (m_mapFile.IsOpen())
+    {
+        //file could grow after size checking
+        auto data = m_mapFile.GetView(0, m_mapFile.GetSize());
+        if (data.size() <= fileOffset)
+            //truncated after size checking
+            return Load(true);
+        m_fileSize = data.size();
+        if (m_fileSize > MAX_PARSED_SIZE)
+            m_lexParser.EnableParsing(false);
+
+        size_t threads{ g_editorConfig.loadThreads ? g_editorConfig.loadThreads : std::thread::hardware_concurrency() };
+        threads = std::max(static_cast<size_t>(1), std::min(threads, static_cast<size_t>((m_fileSize - fileOffset) / c_loadChunkSize)));
+
+        std::vector<std::vector<strbuff_ptr>> parts;
+        rc = IndexParallel(data, fileOffset, threads, parts);
+        if (rc)
+        {
+            if (m_lexParser.IsParsing())
+                StartLex(data, GetStrCount(), lexState);
+            for (auto& part : parts)
+                for (auto& strBuff : part)
+                {
+                    m_buffer.AppendBuff(strBuff);
+                    LexBuff(strBuff);
+                }
+            EndLex();
+        }
+    }
+    else
+    {
+        std::ifstream file{ m_file, std::ios::binary };
+        m_fileSize = fileSize;
+        m_lexParser.SetState(lexState);
+        rc = file && ReadBlocks(file, fileOffset);
+    }
+    EditorApp::ShowProgressBar();
+
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG(DEBUG) << __FUNC__ << " offset=" << fileOffset << " size=" << m_fileSize << " new str=" << GetStrCount() - prevStr << " time=" << time << "ms";
+    _assert(rc);
+    return rc;
+}
+
+bool Editor::LoadPiecesTail()
+{
+    //pieces keep offsets in original file, so it is mapped again and only new strings are scanned
+    OpenFile();
+    auto data = m_mapFile.GetView(0, m_mapFile.GetSize());
+    if (data.size() <= m_fileSize)
+        //truncated after size checking or not mapped
+        return Load(true);
+    m_pieces.SetOriginal(data);
+
+    auto lexState{ m_lexEndState };
+    if (GetStrCount() != m_lexEndLine)
+        lexState = {};
+    //not finished string is read again if it was not changed
+    if (m_fileSize && data[static_cast<size_t>(m_fileSize - 1)] != S_LF && m_pieces.DelLastOriginalStr())
+        lexState = GetStrCount() == m_lexBlockLine ? m_lexBlockState : LexParser::LexState{};
+    m_lexParser.Clear(GetStrCount());
+    m_lexParser.SetState(lexState);
+
+    auto start{ std::chrono::steady_clock::now() };
+    size_t prevStr{ GetStrCount() };
+    uint64_t fileOffset{ m_pieces.GetOriginalSize() };
+    m_fileSize = data.size();
+    if (m_fileSize > MAX_PARSED_SIZE)
+        m_lexParser.EnableParsing(false);
+    bool rc = LoadPieces(fileOffset);
+
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    LOG(DEBUG) << __FUNC__ << " offset=" << fileOffset << " size=" << m_fileSize << " new str=" << GetStrCount() - prevStr << " time=" << time << "ms";
+    _assert(rc);
+    return rc;
+}
+
+bool Editor::ReadBlocks(std::ifstream& file, uintmax_t fileOffset)
+{
+    if (fileOffset >= m_fileSize)
+        return true;
+
+    time_t t1{ time(nullptr) };
+    size_t blockSize{ m_buffer.GetBlockSize() };
+    file.seekg(fileOffset);
+
+    //file is read right to pool blocks, only the tail of last string is moved to the next block
+    auto strBuff{ std::make_shared<StrBuff<std::string, std::string_view>>(blockSize) };
+    size_t rest{};
+    for (;;)
+    {
+        auto data{ strBuff->GetBuff() };
+        if (!data)
+        {
+            //no memory
+            _assert(0);
+            return false;
+        }
+
+        size_t toRead{ static_cast<size_t>(std::min(static_cast<uintmax_t>(blockSize - rest), m_fileSize - fileOffset - rest)) };
+        data->resize(rest + toRead);
+        file.read(data->data() + rest, toRead);
+        size_t size{ rest + static_cast<size_t>(file.gcount()) };
+        if (size < rest + toRead)
+        {
+            //file was truncated
+            data->resize(size);
+            m_fileSize = fileOffset + size;
+        }
+        bool last{ fileOffset + size == m_fileSize };
+
+        if (fileOffset == 0 && m_cp == "UTF-8" && data->substr(0, 3) == c_utf8Bom)
+            m_bom = true;
+
+        strBuff->m_fileOffset = fileOffset;
+        size_t line{ m_buffer.m_totalStrCount };
+        m_lexBlockState = m_lexParser.GetState();
+        m_lexBlockLine = line;
+        ScanStrOffset(data->c_str(), size, last, 0 == fileOffset, [this, &strBuff, &data, &line](uint32_t offset) {
+            uint32_t begin{ strBuff->m_strOffsetList.empty() ? 0 : strBuff->m_strOffsetList.back() };
+            LexStr(m_lexParser, line++, { data->data() + begin, offset - begin });
+            strBuff->m_strOffsetList.push_back(offset);
+        });
+        if (strBuff->m_strOffsetList.empty())
+        {
+            _assert(0);
+            strBuff->ReleaseBuff();
+            return false;
+        }
+        strBuff->m_strOffsetList.shrink_to_fit();
+        m_lexEndState = m_lexParser.GetState();
+        m_lexEndLine = line;
+
+        size_t used{ strBuff->GetBuffSize() };
+        rest = size - used;
+        std::shared_ptr<StrBuff<std::string, std::string_view>> next;
+        if (!last)
+        {
+            next = std::make_shared<StrBuff<std::string, std::string_view>>(blockSize);
+            auto nextData{ next->GetBuff() };
+            if (!nextData)
+            {
+                _assert(0);
+                strBuff->ReleaseBuff();
+                return false;
+            }
+            nextData->assign(data->data() + used, rest);
+            next->ReleaseBuff();
+        }
+
+        data->resize(used);
+        data.reset();
+        strBuff->ReleaseBuff();
+        if (m_mapFile.IsOpen())
+            //block will be read from mapped file
+            strBuff->DropBuff();
+        m_buffer.AppendBuff(strBuff);
+        fileOffset += used;
+
+        time_t t2{ time(nullptr) };
+        if (t1 != t2 && m_fileSize)
+        {
+            t1 = t2;
+            EditorApp::ShowProgressBar(static_cast<size_t>(fileOffset * 100 / m_fileSize));
+        }
+
+        if (last)
+            break;
+        strBuff = next;
+    }
+
+    return true;
+}
+
+size_t Editor::ScanStrOffset(const char* buff, size_t size, bool last, bool checkEol, const std::function<void(uint32_t)>& addStr)
+{
+    //1 byte is reserved for 0xA so 0D and 0A EOL will go to same buffers
+    //and we not get left empty string
+    const size_t maxsize{ !last ? size - 1 : size };
+    const size_t maxtab{ 10 };
+    size_t cr{};
+    size_t crlf{};
+    size_t lf{};
+    size_t len{};
+
+    size_t begin{};
+    size_t i;
+
+    for (i = 0; i < maxsize; ++i)
+    {
+        if (len + 1 < m_maxStrlen)
+        {
+            //skip ordinary symbols in bulk, but stop before string length limit
+            size_t end = std::min(maxsize, i + (m_maxStrlen - 1 - len));
+            size_t next = i + StrScan::FindBreak(buff + i, end - i);
+            len += next - i;
+            i = next;
+            if (i == maxsize)
+                break;
+        }
+
         unsigned char ch = buff[i];
         ++len;
         if (ch == S_TAB)
@@ -500,31 +1538,30 @@ bool Editor::FillStrOffset(std::shared_ptr<StrBuff<std::string, std::string_view
             else
                 ++cr;
 
-            m_lexParser.ScanStr(m_buffer.m_totalStrCount + strBuff->GetStrCount(), {buff + begin, i - begin}, m_cp);
-            strBuff->m_strOffsetList.push_back(static_cast<uint32_t>(i + 1));
+            addStr(static_cast<uint32_t>(i + 1));
             begin = i + 1;
             len = 0;
-            cut = 0;
         }
         else if (ch == S_LF)
         {
             ++lf;
 
-            m_lexParser.ScanStr(m_buffer.m_totalStrCount + strBuff->GetStrCount(), { buff + begin, i - begin }, m_cp);
-            strBuff->m_strOffsetList.push_back(static_cast<uint32_t>(i + 1));
+            addStr(static_cast<uint32_t>(i + 1));
             begin = i + 1;
             len = 0;
-            cut = 0;
-        }
-        else
-        {
-            //check symbol type
-            if (GetSymbolType(ch) != symbol_t::alnum)
-                cut = i;
         }
 
         if (len >= m_maxStrlen)
         {
+            //the last not word symbol is searched only for long string
+            size_t cut{};
+            for (size_t j = i + 1; j > begin; --j)
+                if (buff[j - 1] != S_TAB && GetSymbolType(static_cast<unsigned char>(buff[j - 1])) != symbol_t::alnum)
+                {
+                    cut = j - 1;
+                    break;
+                }
+
             //wrap for long string
             if (buff[i + 1] == S_CR)
             {
@@ -548,22 +1585,19 @@ bool Editor::FillStrOffset(std::shared_ptr<StrBuff<std::string, std::string_view
                 i = cut;
             }
 
-            m_lexParser.ScanStr(m_buffer.m_totalStrCount + strBuff->GetStrCount(), { buff + begin, i - begin }, m_cp);
-            strBuff->m_strOffsetList.push_back(static_cast<uint32_t>(i + 1));
+            addStr(static_cast<uint32_t>(i + 1));
             begin = i + 1;
             len = 0;
-            cut = 0;
         }
     }
 
     if (len && last)
     {
-        //parse last string in file
-        m_lexParser.ScanStr(m_buffer.m_totalStrCount + strBuff->GetStrCount(), { buff + begin, i - begin }, m_cp);
-        strBuff->m_strOffsetList.push_back(static_cast<uint32_t>(i));
+        //last string in file
+        addStr(static_cast<uint32_t>(i));
     }
 
-    if (0 == strBuff->m_fileOffset)
+    if (checkEol)
     {
         auto eol = m_eol;
         auto m = std::max({lf, crlf, cr});
@@ -577,12 +1611,7 @@ bool Editor::FillStrOffset(std::shared_ptr<StrBuff<std::string, std::string_view
         LOG_IF(eol != m_eol, DEBUG) << "cr=" << cr << " lf=" << lf << " crlf=" << crlf;
     }
 
-    str->resize(i);
-    _assert(i <= BUFF_SIZE);
-    rest = size - strBuff->GetBuffSize();
-    strBuff->ReleaseBuff();
-
-    return true;
+    return i;
 }
 
 bool Editor::FlushCurStr()
@@ -619,6 +1648,7 @@ bool Editor::SetCurStr(size_t line)
 void Editor::SetTab(size_t tabsize) 
 { 
     FlushCurStr();
+    m_improveAll |= m_tab != tabsize;
     m_tab = tabsize;
     m_curStrBuff = _GetStr(m_curStr, 0, m_maxStrlen);
 }
@@ -639,7 +1669,7 @@ std::u16string  Editor::GetStr(size_t line, size_t offset, size_t size)
 
 std::u16string Editor::_GetStr(size_t line, size_t offset, size_t size)
 {
-    if (line >= m_buffer.GetStrCount())
+    if (line >= GetStrCount())
     {
         if(offset + size <= m_maxStrlen)
             return std::u16string(size - offset, ' ');
@@ -647,7 +1677,7 @@ std::u16string Editor::_GetStr(size_t line, size_t offset, size_t size)
             return {};
     }
 
-    auto str{ m_buffer.GetStr(line) };
+    auto str{ GetBuffStr(line) };
     if (line == 0 && m_bom)
     {
         //remove bom
@@ -694,17 +1724,17 @@ std::u16string Editor::_GetStr(size_t line, size_t offset, size_t size)
             break;
     }
 
-    m_buffer.ReleaseBuff();
+    ReleaseBuff();
 
     return outstr;
 }
 
 std::u16string Editor::GetStrForFind(size_t line, bool checkCase, bool fast)
 {
-    if (line >= m_buffer.GetStrCount())
+    if (line >= GetStrCount())
             return {};
 
-    auto str{ m_buffer.GetStr(line) };
+    auto str{ GetBuffStr(line) };
     std::u16string outstr;
     if (fast)
     {
@@ -765,7 +1795,7 @@ std::u16string Editor::GetStrForFind(size_t line, bool checkCase, bool fast)
                 ++pos;
         }
     }
-    m_buffer.ReleaseBuff();
+    ReleaseBuff();
 
     return outstr;
 }
@@ -831,6 +1861,8 @@ bool Editor::ConvertStr(const std::u16string& str, std::string& buff) const
 
 bool Editor::ChangeStr(size_t n, const std::u16string& wstr)
 {
+    //background scan reads only the blocks after the string
+    WaitLex(n);
     //LOG(DEBUG) << "ChangeStr " << n << " total=" << GetStrCount();
 
     if (n >= GetStrCount())
@@ -841,7 +1873,7 @@ bool Editor::ChangeStr(size_t n, const std::u16string& wstr)
 
     std::string str;
     bool rc = ConvertStr(wstr, str);
-    rc = m_buffer.ChangeStr(n, str);
+    rc = m_usePieces ? m_pieces.ChangeStr(n, str) : m_buffer.ChangeStr(n, str);
 
     return rc;
 }
@@ -862,6 +1894,9 @@ char Editor::GetAccessInfo()
 
 bool Editor::GetColor(size_t line, const std::u16string& str, std::vector<color_t>& buff, size_t len)
 {
+    //color depends on previous strings
+    if (line < GetStrCount())
+        WaitLex(line);
     return m_lexParser.GetColor(line, str, buff, len);
 }
 
@@ -894,11 +1929,15 @@ bool Editor::AddStr(size_t n, const std::u16string& wstr)
 
 bool Editor::_AddStr(size_t n, const std::u16string& wstr)
 {
+    //background scan is suspended after the string and goes on with moved lines
+    bool lex = SuspendLex(n);
     //LOG(DEBUG) << "AddStr n=" << n;
 
     std::string str;
     bool rc = ConvertStr(wstr, str);
-    rc = m_buffer.AddStr(n, str);
+    rc = m_usePieces ? m_pieces.AddStr(n, str) : m_buffer.AddStr(n, str);
+    if (lex)
+        ResumeLex(rc ? 1 : 0);
 
     return rc;
 }
@@ -945,7 +1984,7 @@ bool Editor::AddSubstr(bool save, size_t line, size_t pos, const std::u16string&
         m_curChanged = true;
         if (save)
         {
-            m_undoList.AddEditCmd(cmd_t::CMD_ADD_SUBSTR, line, pos, 0, substr.size(), substr);
+            AddEditCmd(cmd_t::CMD_ADD_SUBSTR, line, pos, 0, substr.size(), substr);
             m_undoList.AddUndoCmd(cmd_t::CMD_DEL_SUBSTR, line, pos, 0, substr.size(), {});
         }
 
@@ -977,7 +2016,7 @@ bool Editor::ChangeSubstr(bool save, size_t line, size_t pos, const std::u16stri
         m_curChanged = true;
         if (save)
         {
-            m_undoList.AddEditCmd(cmd_t::CMD_CHANGE_SUBSTR, line, pos, 0, substr.size(), substr);
+            AddEditCmd(cmd_t::CMD_CHANGE_SUBSTR, line, pos, 0, substr.size(), substr);
             m_undoList.AddUndoCmd(cmd_t::CMD_CHANGE_SUBSTR, line, pos, 0, substr.size(), prevStr);
         }
 
@@ -1029,7 +2068,7 @@ bool Editor::CorrectTab(bool save, size_t line, std::u16string& str)
 
     if (save && !tabs.empty())
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_CORRECT_TAB, line, 0, 0, 0, {});
+        AddEditCmd(cmd_t::CMD_CORRECT_TAB, line, 0, 0, 0, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_RESTORE_TAB, line, 0, 0, tabs.size(), tabs);
     }
 
@@ -1065,7 +2104,7 @@ bool Editor::AddLine(bool save, size_t line, const std::u16string& str)
 
     if (save)
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_ADD_LINE, line, 0, 0, str.size(), str);
+        AddEditCmd(cmd_t::CMD_ADD_LINE, line, 0, 0, str.size(), str);
         m_undoList.AddUndoCmd(cmd_t::CMD_DEL_LINE, line, 0, count, 0, {});
     }
 
@@ -1089,7 +2128,7 @@ bool Editor::DelSubstr(bool save, size_t line, size_t pos, size_t len)
 
     if (save)
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_DEL_SUBSTR, line, pos, 0, len, {});
+        AddEditCmd(cmd_t::CMD_DEL_SUBSTR, line, pos, 0, len, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_ADD_SUBSTR, line, pos, 0, len, prevStr);
     }
 
@@ -1102,13 +2141,16 @@ bool Editor::DelLine(bool save, size_t line, size_t count)
 {
     if (line >= GetStrCount())
         return true;
+    //deleted strings are not after the line
+    bool lex = SuspendLex(line);
+    size_t deleted{ std::max<size_t>(count, 1) };
 
     if (save)
     {
         auto str{ GetStr(line) };
         size_t len{ UStrLen(str) };
 
-        m_undoList.AddEditCmd(cmd_t::CMD_DEL_LINE, line, 0, count, 0, {});
+        AddEditCmd(cmd_t::CMD_DEL_LINE, line, 0, count, 0, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_ADD_LINE, line, 0, 0, len, str);
     }
 
@@ -1120,18 +2162,21 @@ bool Editor::DelLine(bool save, size_t line, size_t count)
     else if (line < m_curStr)
         --m_curStr;
 
-    bool rc = m_buffer.DelStr(line);
+    bool rc = m_usePieces ? m_pieces.DelStr(line) : m_buffer.DelStr(line);
     invalidate_t inv;
     m_lexParser.DelStr(line, inv);
     InvalidateWnd(line, inv);
 
     while (count-- > 1)
     {
-        rc = m_buffer.DelStr(--line);
+        --line;
+        rc = m_usePieces ? m_pieces.DelStr(line) : m_buffer.DelStr(line);
         m_lexParser.DelStr(line, inv);
         InvalidateWnd(line, invalidate_t::del);
     }
 
+    if (lex)
+        ResumeLex(-static_cast<int64_t>(deleted));
     return rc;
 }
 
@@ -1170,7 +2215,7 @@ bool Editor::MergeLine(bool save, size_t line, size_t pos, size_t indent)
 
     if (save)
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_MERGE_LINE, line, pos, indent, 0, {});
+        AddEditCmd(cmd_t::CMD_MERGE_LINE, line, pos, indent, 0, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_SPLIT_LINE, line, pos, indent, 0, {});
     }
 
@@ -1201,7 +2246,7 @@ bool Editor::SplitLine(bool save, size_t line, size_t pos, size_t indent)
 
     if (save)
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_SPLIT_LINE, line, pos, indent, 0, {});
+        AddEditCmd(cmd_t::CMD_SPLIT_LINE, line, pos, indent, 0, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_MERGE_LINE, line, pos, indent, 0, {});
     }
 
@@ -1229,7 +2274,7 @@ bool Editor::SaveTab(bool save, size_t line)
 
     if (save && !tabs.empty())
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_SAVE_TAB, line, 0, 0, 0, {});
+        AddEditCmd(cmd_t::CMD_SAVE_TAB, line, 0, 0, 0, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_RESTORE_TAB, line, 0, 0, tabs.size(), tabs);
     }
 
@@ -1268,7 +2313,7 @@ bool Editor::ClearSubstr(bool save, size_t line, size_t pos, size_t len)
 
     if (save)
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_CLEAR_SUBSTR, line, pos, 0, len, {});
+        AddEditCmd(cmd_t::CMD_CLEAR_SUBSTR, line, pos, 0, len, {});
         m_undoList.AddUndoCmd(cmd_t::CMD_CHANGE_SUBSTR, line, pos, 0, len, prevstr);
     }
 
@@ -1294,7 +2339,7 @@ bool Editor::ReplaceSubstr(bool save, size_t line, size_t pos, size_t len, const
 
     if (save)
     {
-        m_undoList.AddEditCmd(cmd_t::CMD_REPLACE_SUBSTR, line, pos, len, substr.size(), substr);
+        AddEditCmd(cmd_t::CMD_REPLACE_SUBSTR, line, pos, len, substr.size(), substr);
         m_undoList.AddUndoCmd(cmd_t::CMD_REPLACE_SUBSTR, line, pos, substr.size(), len, prevStr);
     }
 
@@ -1330,7 +2375,7 @@ bool Editor::Indent(bool save, size_t line, size_t pos, size_t len, size_t n)
 
         if (save)
         {
-            m_undoList.AddEditCmd(cmd_t::CMD_INDENT, line, pos, count, len, {});
+            AddEditCmd(cmd_t::CMD_INDENT, line, pos, count, len, {});
             m_undoList.AddUndoCmd(cmd_t::CMD_UNINDENT, line, pos, count, len, {});
         }
 
@@ -1367,7 +2412,7 @@ bool Editor::Unindent(bool save, size_t line, size_t pos, size_t len, size_t n)
 
         if (save)
         {
-            m_undoList.AddEditCmd(cmd_t::CMD_UNINDENT, line, pos, count, len, {});
+            AddEditCmd(cmd_t::CMD_UNINDENT, line, pos, count, len, {});
             m_undoList.AddUndoCmd(cmd_t::CMD_INDENT, line, pos, count, len, {});
         }
 
@@ -1377,6 +2422,30 @@ bool Editor::Unindent(bool save, size_t line, size_t pos, size_t len, size_t n)
     return true;
 }
 
+bool Editor::AddEditCmd(cmd_t command, size_t line, size_t pos, size_t count, size_t len, const std::u16string& str)
+{
+    Journal(command, line, pos, count, len, str);
+    return m_undoList.AddEditCmd(command, line, pos, count, len, str);
+}
+
+void Editor::Journal(cmd_t command, size_t line, size_t pos, size_t count, size_t len, const std::u16string& str)
+{
+    if (!m_changeTime)
+        m_changeTime = time(nullptr);
+    ++m_editCount;
+
+    if (!m_journal.IsOpen())
+    {
+        //journal is created with the first change, only for existing file
+        std::error_code ec;
+        if (m_journalOff || !g_editorConfig.editJournal || !std::filesystem::is_regular_file(m_file, ec))
+            return;
+        m_journalOff = !m_journal.Open(GetJournalPath(), GetJournalHeader());
+    }
+
+    m_journal.Add(command, line, pos, count, len, str);
+}
+
 bool Editor::AddUndoCommand(const EditCmd& editCmd, const EditCmd& undoCmd)
 {
     m_undoList.AddEditCmd(editCmd.command, editCmd.line, editCmd.pos, editCmd.count, editCmd.len, editCmd.str);
@@ -1387,13 +2456,18 @@ bool Editor::AddUndoCommand(const EditCmd& editCmd, const EditCmd& undoCmd)
 
 bool Editor::ClearModifyFlag()
 {
-    m_buffer.ClearModifyFlag();
+    //blocks are cleared while saving, after undo they still differ from file
+    m_buffer.m_changed = false;
+    m_pieces.ClearModifyFlag();
     m_curChanged = false;
+    m_changeTime = 0;
     return true;
 }
 
 bool Editor::Command(const EditCmd& cmd)
 {
+    //undo and redo commands are applied without undo list, so they are journaled here
+    Journal(cmd.command, cmd.line, cmd.pos, cmd.count, cmd.len, cmd.str);
     bool rc{};
 
     switch (cmd.command)
@@ -1450,6 +2524,7 @@ bool Editor::Command(const EditCmd& cmd)
 
 bool Editor::CheckLexPair(size_t& line, size_t& pos)
 {
+    WaitLex();
     auto str{ GetStr(line, 0, m_maxStrlen) };
     size_t y{ line };
     char16_t c{ str[pos] };
@@ -1465,13 +2540,47 @@ bool Editor::CheckLexPair(size_t& line, size_t& pos)
     return m_lexParser.GetLexPair(str, line, c, pos);
 }
 
-bool Editor::Save()
+bool Editor::Save(bool background)
 {
     LOG(DEBUG) << "Save " << m_file.u8string();
     time_t start{ time(NULL) };
 
+    WaitSave();
+    //failed saving is repeated by autosave after full period
+    if (m_changeTime)
+        m_changeTime = time(nullptr);
+    //indexing reads mapped file
+    WaitIndex();
+    WaitLex();
+    //zeros read from truncated file are not written instead of lost strings
+    CheckMapping();
     bool rc = FlushCurStr();
     rc = BackupFile();
+    if (m_usePieces)
+        return SavePieces();
+    if (g_editorConfig.atomicSave)
+    {
+        //file is overwritten in place if new file can't replace it
+        if (m_saveFile.Open(m_file))
+        {
+            try
+            {
+                return background ? StartSave() : SaveAtomic();
+            }
+            catch (...)
+            {
+                m_saveFile.Discard();
+                throw;
+            }
+        }
+        LOG(INFO) << "atomic save is not possible, overwrite " << m_file.u8string();
+    }
+
+    //file will be overwritten, all blocks are read to pool
+    m_buffer.ResetMapping();
+    CheckMapping();
+    m_mapFile.Close();
+    m_reader.Close();
 
     auto filePath{ m_file };
     std::fstream file{ filePath, std::ios::binary|std::ios::in|std::ios::out };
@@ -1496,108 +2605,571 @@ bool Editor::Save()
         return true;
     };
 
-    time_t t1{ time(nullptr) };
-    size_t percent{};
-    auto step{ GetSize() / 100 };//1%
-
-    size_t buffOffset{ 0 };
+    time_t t1{ time(nullptr) };
+    size_t percent{};
+    auto step{ GetSize() / 100 };//1%
+
+    //not modified blocks are not improved, and they are not written if they stay on their places,
+    //so only changed blocks are written or file tail after the first block with changed size
+    bool writeAll{ m_improveAll
+        || std::filesystem::file_size(filePath) != m_fileSize || std::filesystem::last_write_time(filePath) != m_fileTime };
+    uint64_t written{};
+
+    size_t buffOffset{ 0 };
+    for (auto buffIt = m_buffer.m_buffList.begin(); buffIt != m_buffer.m_buffList.end(); ++buffIt)
+    {
+        auto& buffPtr = *buffIt;
+        if (!writeAll && !buffPtr->m_mod && buffPtr->m_fileOffset == buffOffset)
+        {
+            buffOffset += buffPtr->GetBuffSize();
+            continue;
+        }
+
+        auto buffStr = buffPtr->GetBuff();
+        if (!buffStr)
+        {
+            //error
+            _assert(0);
+            throw std::runtime_error{ "GetBuffer" };
+        }
+        if (buffPtr->m_lostData)
+        {
+            rc = Load(buffPtr->m_fileOffset, buffPtr->GetBuffSize(), buffStr);
+            if (!rc)
+            {
+                //error
+                _assert(0);
+                throw std::runtime_error{ "LoadBuff" };
+            }
+            buffPtr->m_lostData = false;
+        }
+
+        if(buffPtr->m_strOffsetList.empty())
+        {
+            buffPtr->ClearModifyFlag();
+            buffPtr->ReleaseBuff();
+            continue;
+        }
+
+        if (m_improveAll || buffPtr->m_mod)
+            rc = ImproveBuff(buffIt);
+        //block pointer can be changed while improving
+        buffStr = buffPtr->GetBuff();
+        buffPtr->CloseGap();
+
+        buffPtr->m_fileOffset = buffOffset;
+        size_t buffSize = buffPtr->GetBuffSize();
+
+        auto nextIt = buffIt;
+        while (++nextIt != m_buffer.m_buffList.end())
+        {
+            auto& nextBuffPtr = *nextIt;
+            //check next buffer for begin offset
+            if (nextBuffPtr->m_fileOffset < buffOffset + buffSize)
+            {
+                //read ahead before write    
+                auto nextBuffStr = nextBuffPtr->GetBuff();
+                if (!nextBuffStr)
+                {
+                    //error
+                    _assert(0);
+                    throw std::runtime_error{ "GetBuffer" };
+                }
+                if (nextBuffPtr->m_lostData)
+                {
+                    rc = Load(nextBuffPtr->m_fileOffset, nextBuffPtr->GetBuffSize(), nextBuffStr);
+                    if (!rc)
+                    {
+                        //error
+                        _assert(0);
+                        throw std::runtime_error{ "LoadBuff" };
+                    }
+                    nextBuffPtr->m_lostData = false;
+                }
+            }
+            else
+                break;
+        }
+
+        file.seekp(buffOffset);
+        file.write(buffStr->data(), buffSize);
+        _assert(file.good());
+        written += buffSize;
+
+        buffPtr->ClearModifyFlag();
+        buffPtr->ReleaseBuff();
+        buffOffset += buffSize;
+
+        time_t t2{ time(NULL) };
+        if (t1 != t2 && step)
+        {
+            t1 = t2;
+            size_t pr{ static_cast<size_t>(buffOffset / step) };
+            if (pr != percent)
+            {
+                percent = pr;
+                EditorApp::ShowProgressBar(pr);
+            }
+        }
+    }
+
+    file.close();
+    auto fsize = std::filesystem::file_size(filePath);
+    if (fsize > buffOffset)
+    {
+        std::filesystem::resize_file(filePath, buffOffset);
+    }
+
+    m_fileTime = std::filesystem::last_write_time(m_file);
+    m_fileSize = std::filesystem::file_size(m_file);
+
+    m_journal.Close(true);
+    rc = ClearModifyFlag();
+    m_improveAll = false;
+    OpenFile();
+    EditorApp::ShowProgressBar();
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
+
+    LOG(DEBUG) << "save time=" << time(nullptr) - start << " written=" << written << " size=" << buffOffset;
+
+    return rc;
+}
+
+bool Editor::SaveAtomic()
+{
+    time_t start{ time(NULL) };
+    time_t t1{ time(NULL) };
+    size_t percent{};
+    auto step{ GetSize() / 100 };//1%
+
+    //original file stays untouched till rename, so not modified blocks can be copied from it
+    //if it was not changed by somebody else
+    bool copyClean{ !m_improveAll
+        && std::filesystem::file_size(m_file) == m_fileSize && std::filesystem::last_write_time(m_file) == m_fileTime };
+
+    //file is opened by Save
+    auto& file{ m_saveFile };
+    EditorApp::SetHelpLine("Wait for file saving");
+
+    uint64_t copyOffset{};
+    uint64_t copySize{};
+    auto Copy = [&]() {
+        if (copySize && !file.Copy(copyOffset, copySize))
+            throw std::runtime_error{"copy file " + file.GetTmpPath().u8string()};
+        copySize = 0;
+    };
+
+    //block offsets are changed only after replacing of file
+    std::vector<uint64_t> newOffset;
+    newOffset.reserve(m_buffer.m_buffList.size());
+    uint64_t written{};
+    uint64_t buffOffset{};
+    for (auto buffIt = m_buffer.m_buffList.begin(); buffIt != m_buffer.m_buffList.end(); ++buffIt)
+    {
+        auto& buffPtr = *buffIt;
+        newOffset.push_back(buffOffset);
+        if (copyClean && !buffPtr->m_mod)
+        {
+            //neighbour clean blocks are copied by one range
+            if (copySize && copyOffset + copySize == buffPtr->m_fileOffset)
+                copySize += buffPtr->GetBuffSize();
+            else
+            {
+                Copy();
+                copyOffset = buffPtr->m_fileOffset;
+                copySize = buffPtr->GetBuffSize();
+            }
+            buffOffset += buffPtr->GetBuffSize();
+            continue;
+        }
+        Copy();
+
+        auto buffStr = buffPtr->GetBuff();
+        if (!buffStr)
+        {
+            //error
+            _assert(0);
+            throw std::runtime_error{ "GetBuffer" };
+        }
+        if (buffPtr->m_lostData)
+        {
+            if (!LoadBuff(buffPtr->m_fileOffset, buffPtr->GetBuffSize(), buffStr))
+            {
+                //error
+                _assert(0);
+                throw std::runtime_error{ "LoadBuff" };
+            }
+            buffPtr->m_lostData = false;
+        }
+
+        if (!buffPtr->m_strOffsetList.empty())
+        {
+            if (m_improveAll || buffPtr->m_mod)
+                ImproveBuff(buffIt);
+            //block pointer can be changed while improving
+            buffStr = buffPtr->GetBuff();
+            buffPtr->CloseGap();
+
+            size_t buffSize = buffPtr->GetBuffSize();
+            if (!file.Write(buffStr->data(), buffSize))
+                throw std::runtime_error{"write file " + file.GetTmpPath().u8string()};
+            written += buffSize;
+            buffOffset += buffSize;
+        }
+
+        //modified block is kept in pool as dirty till file is replaced
+        buffPtr->ReleaseBuff();
+
+        time_t t2{ time(NULL) };
+        if (t1 != t2 && step)
+        {
+            t1 = t2;
+            size_t pr{ static_cast<size_t>(buffOffset / step) };
+            if (pr != percent)
+            {
+                percent = pr;
+                EditorApp::ShowProgressBar(pr);
+            }
+        }
+    }
+    Copy();
+
+    //file can't be replaced while it is mapped in some OS
+    m_buffer.ResetMapping();
+    CheckMapping();
+    m_mapFile.Close();
+    m_reader.Close();
+    if (!file.Commit())
+    {
+        //old file was not changed
+        OpenFile();
+        throw std::runtime_error{"rename file " + file.GetTmpPath().u8string()};
+    }
+
+    size_t n{};
+    for (auto& buffPtr : m_buffer.m_buffList)
+    {
+        buffPtr->m_fileOffset = newOffset[n++];
+        if (buffPtr->m_mod)
+        {
+            //saved block can be dropped from pool and loaded again
+            buffPtr->GetBuff();
+            buffPtr->ClearModifyFlag();
+        }
+    }
+
+    m_fileTime = std::filesystem::last_write_time(m_file);
+    m_fileSize = std::filesystem::file_size(m_file);
+    m_fileId = GetFileId(m_file);
+    //notification was set for replaced file
+    Unwatch();
+    Watch();
+
+    m_journal.Close(true);
+    bool rc = ClearModifyFlag();
+    m_improveAll = false;
+    OpenFile();
+    EditorApp::ShowProgressBar();
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
+
+    LOG(DEBUG) << "save time=" << time(nullptr) - start << " written=" << written << " size=" << buffOffset;
+
+    return rc;
+}
+
+bool Editor::StartSave()
+{
+    //all blocks are read for changed saving options or for file changed by somebody else
+    if (m_improveAll
+        || std::filesystem::file_size(m_file) != m_fileSize || std::filesystem::last_write_time(m_file) != m_fileTime)
+        return SaveAtomic();
+
+    auto Cancel = [this]() {
+        for (auto& block : m_saveBlocks)
+            block.strBuff->m_shared = false;
+        m_saveBlocks.clear();
+        m_saveFile.Discard();
+    };
+
+    //snapshot takes O(blocks): modified blocks are improved and pinned in pool,
+    //not modified ones are copied from original file
+    m_saveBlocks.clear();
+    m_saveBlocks.reserve(m_buffer.m_buffList.size());
+    m_saveSize = 0;
     for (auto buffIt = m_buffer.m_buffList.begin(); buffIt != m_buffer.m_buffList.end(); ++buffIt)
     {
         auto& buffPtr = *buffIt;
-        auto buffStr = buffPtr->GetBuff();
-        if (!buffStr)
-        {
-            //error
-            _assert(0);
-            throw std::runtime_error{ "GetBuffer" };
-        }
-        if (buffPtr->m_lostData)
+        SaveBlock block;
+        block.strBuff = buffPtr;
+        if (buffPtr->m_mod && !buffPtr->m_strOffsetList.empty())
         {
-            rc = Load(buffPtr->m_fileOffset, buffPtr->GetBuffSize(), buffStr);
-            if (!rc)
+            auto buffStr = buffPtr->GetBuff();
+            if (!buffStr || (buffPtr->m_lostData && !LoadBuff(buffPtr->m_fileOffset, buffPtr->GetBuffSize(), buffStr)))
             {
                 //error
                 _assert(0);
-                throw std::runtime_error{ "LoadBuff" };
+                buffPtr->ReleaseBuff();
+                Cancel();
+                throw std::runtime_error{ "GetBuffer" };
             }
             buffPtr->m_lostData = false;
-        }
 
-        if(buffPtr->m_strOffsetList.empty())
-        {
-            buffPtr->ClearModifyFlag();
+            ImproveBuff(buffIt);
+            buffPtr->GetBuff();
+            buffPtr->CloseGap();
+            block.pin = buffPtr->Pin();
             buffPtr->ReleaseBuff();
-            continue;
         }
+        block.fileOffset = buffPtr->m_fileOffset;
+        block.size = buffPtr->GetBuffSize();
+        buffPtr->m_shared = true;
+        m_saveSize += block.size;
+        m_saveBlocks.push_back(std::move(block));
+    }
 
-        rc = ImproveBuff(buffIt);
-
-        buffPtr->m_fileOffset = buffOffset;
-        size_t buffSize = buffPtr->GetBuffSize();
-
-        auto nextIt = buffIt;
-        while (++nextIt != m_buffer.m_buffList.end())
-        {
-            auto& nextBuffPtr = *nextIt;
-            //check next buffer for begin offset
-            if (nextBuffPtr->m_fileOffset < buffOffset + buffSize)
+    m_saveOffset = 0;
+    m_saveDone = false;
+    m_saveError = false;
+    m_saving = true;
+    try
+    {
+        m_saveThread = std::thread([this]() {
+            auto start{ std::chrono::steady_clock::now() };
+            bool rc{ true };
+            uint64_t copyOffset{};
+            uint64_t copySize{};
+            for (auto& block : m_saveBlocks)
             {
-                //read ahead before write    
-                auto nextBuffStr = nextBuffPtr->GetBuff();
-                if (!nextBuffStr)
-                {
-                    //error
-                    _assert(0);
-                    throw std::runtime_error{ "GetBuffer" };
-                }
-                if (nextBuffPtr->m_lostData)
+                if (!block.pin)
                 {
-                    rc = Load(nextBuffPtr->m_fileOffset, nextBuffPtr->GetBuffSize(), nextBuffStr);
-                    if (!rc)
+                    //neighbour not modified blocks are copied by one range
+                    if (copySize && copyOffset + copySize == block.fileOffset)
+                        copySize += block.size;
+                    else
                     {
-                        //error
-                        _assert(0);
-                        throw std::runtime_error{ "LoadBuff" };
+                        rc = !copySize || m_saveFile.Copy(copyOffset, copySize);
+                        copyOffset = block.fileOffset;
+                        copySize = block.size;
                     }
-                    nextBuffPtr->m_lostData = false;
                 }
+                else
+                {
+                    rc = (!copySize || m_saveFile.Copy(copyOffset, copySize)) && m_saveFile.Write(block.pin->data(), block.size);
+                    copySize = 0;
+                }
+                if (!rc)
+                    break;
+                m_saveOffset += block.size;
+            }
+            rc = rc && (!copySize || m_saveFile.Copy(copyOffset, copySize)) && m_saveFile.Sync();
+
+            auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            LOG(DEBUG) << "background save time=" << time << "ms size=" << m_saveFile.GetSize() << " rc=" << rc;
+
+            m_saveError = !rc;
+            m_saveDone = true;
+            EditorApp::getInstance().WakeInput();
+        });
+    }
+    catch (...)
+    {
+        _assert(0);
+        m_saving = false;
+        Cancel();
+        throw std::runtime_error{ "start saving" };
+    }
+
+    //buffer is saved as it is now, next changes are made in copies of blocks;
+    //modify flags stay set till file is replaced
+    m_saveEditCount = m_editCount;
+    //changes after snapshot stay in journal of saved file
+    m_journal.Flush();
+    m_journal.Mark();
+    EditorApp::SetHelpLine("File saving in background");
+    return true;
+}
+
+bool Editor::UpdateSave()
+{
+    if (!m_saving)
+        return false;
+
+    if (!m_saveDone)
+    {
+        if (m_saveSize)
+            EditorApp::ShowProgressBar(static_cast<size_t>(m_saveOffset * 100 / m_saveSize));
+        return false;
+    }
+
+    if (m_saveThread.joinable())
+        m_saveThread.join();
+    m_saving = false;
+    m_saveDone = false;
+
+    bool rc{ !m_saveError };
+    if (rc)
+    {
+        //file can't be replaced while it is mapped in some OS
+        m_buffer.ResetMapping();
+        rc = !m_mapFile.IsTruncated();
+        m_mapFile.Close();
+        m_reader.Close();
+    }
+    if (rc)
+        rc = m_saveFile.Commit();
+    else
+        m_saveFile.Discard();
+
+    //offsets and modify flags are changed only for blocks that were not changed while saving
+    uint64_t offset{};
+    for (auto& block : m_saveBlocks)
+    {
+        auto& strBuff = block.strBuff;
+        block.pin.Reset();
+        if (rc && strBuff->m_shared)
+        {
+            strBuff->m_fileOffset = offset;
+            if (strBuff->m_mod)
+            {
+                //saved block can be dropped from pool and loaded again
+                strBuff->GetBuff();
+                strBuff->ClearModifyFlag();
             }
-            else
-                break;
         }
+        strBuff->m_shared = false;
+        offset += block.size;
+    }
+    m_saveBlocks.clear();
 
-        file.seekp(buffOffset);
-        file.write(buffStr->data(), buffSize);
-        _assert(file.good());
+    OpenFile();
+    EditorApp::ShowProgressBar();
+    if (!rc)
+    {
+        //old file was not changed
+        LOG(ERROR) << __FUNC__ << " background save error " << m_file.u8string();
+        //failed saving is repeated by autosave after full period
+        m_changeTime = time(nullptr);
+        m_journal.Unmark();
+        EditorApp::SetErrorLine("File write error");
+        return true;
+    }
 
-        buffPtr->ClearModifyFlag();
-        buffPtr->ReleaseBuff();
-        buffOffset += buffSize;
+    m_fileTime = std::filesystem::last_write_time(m_file);
+    m_fileSize = std::filesystem::file_size(m_file);
+    m_fileId = GetFileId(m_file);
+    //notification was set for replaced file
+    Unwatch();
+    Watch();
+    m_journal.Rebase(GetJournalHeader());
+    if (m_editCount == m_saveEditCount && !m_curChanged)
+    {
+        //nothing was changed while saving
+        m_buffer.m_changed = false;
+        m_changeTime = 0;
+    }
 
-        time_t t2{ time(NULL) };
-        if (t1 != t2 && step)
+    EditorApp::SetHelpLine("Ready", stat_color::grayed);
+    return true;
+}
+
+bool Editor::WaitSave()
+{
+    if (!m_saving)
+        return true;
+
+    EditorApp::SetHelpLine("Wait for file saving");
+    //thread exits right after setting of m_saveDone
+    m_saveThread.join();
+    _assert(m_saveDone);
+    UpdateSave();
+
+    return true;
+}
+
+bool Editor::SavePieces()
+{
+    time_t start{ time(NULL) };
+    time_t t1{ time(NULL) };
+    size_t percent{};
+    auto step{ GetSize() / 100 };//1%
+
+    //pieces refer to mapped file, so we write new file and replace old one
+    auto& file{ m_saveFile };
+    if (!file.Open(m_file))
+        throw std::runtime_error{"open file " + m_file.u8string()};
+
+    EditorApp::SetHelpLine("Wait for file saving");
+
+    StrIndex strEnd;
+    std::string buff;
+    buff.reserve(c_buffsize);
+    std::string outstr;
+    uint64_t fileOffset{};
+
+    for (size_t n = 0; n < GetStrCount(); ++n)
+    {
+        auto str{ m_pieces.GetStr(n) };
+        if (ImproveStr(str, outstr))
+            str = outstr;
+
+        buff += str;
+        fileOffset += str.size();
+        if (!strEnd.Append(fileOffset))
         {
-            t1 = t2;
-            size_t pr{ static_cast<size_t>(buffOffset / step) };
-            if (pr != percent)
+            file.Discard();
+            throw std::runtime_error{"index file " + m_file.u8string()};
+        }
+
+        if (buff.size() >= c_buffsize - MAX_STRLEN)
+        {
+            if (!file.Write(buff.data(), buff.size()))
             {
-                percent = pr;
-                EditorApp::ShowProgressBar(pr);
+                file.Discard();
+                throw std::runtime_error{"write file " + m_file.u8string()};
+            }
+            buff.clear();
+
+            time_t t2{ time(NULL) };
+            if (t1 != t2 && step)
+            {
+                t1 = t2;
+                size_t pr{ static_cast<size_t>(fileOffset / step) };
+                if (pr != percent)
+                {
+                    percent = pr;
+                    EditorApp::ShowProgressBar(pr);
+                }
             }
         }
     }
+    if (!file.Write(buff.data(), buff.size()))
+    {
+        file.Discard();
+        throw std::runtime_error{"write file " + m_file.u8string()};
+    }
 
-    file.close();
-    auto fsize = std::filesystem::file_size(filePath);
-    if (fsize > buffOffset)
+    //saved file becomes original data of piece table
+    if (m_mapFile.IsTruncated())
     {
-        std::filesystem::resize_file(filePath, buffOffset);
+        file.Discard();
+        CheckMapping();
+    }
+    m_mapFile.Close();
+    bool committed = file.Commit();
+    m_mapFile.Open(m_file);
+    if (!committed)
+    {
+        //old file was not changed
+        m_pieces.SetOriginal(m_mapFile.GetView(0, m_mapFile.GetSize()));
+        throw std::runtime_error{"rename file " + m_file.u8string()};
     }
+    m_pieces.Rebase(m_mapFile.GetView(0, m_mapFile.GetSize()), std::move(strEnd));
 
     m_fileTime = std::filesystem::last_write_time(m_file);
     m_fileSize = std::filesystem::file_size(m_file);
 
-    rc = ClearModifyFlag();
+    m_journal.Close(true);
+    bool rc = ClearModifyFlag();
     EditorApp::ShowProgressBar();
     EditorApp::SetHelpLine("Ready", stat_color::grayed);
 
@@ -1612,106 +3184,111 @@ bool Editor::BackupFile()
     return true;
 }
 
-bool Editor::ImproveBuff(std::list<std::shared_ptr<StrBuff<std::string, std::string_view>>>::iterator strIt)
+bool Editor::ImproveBuff(MemStrBuff<std::string, std::string_view>::BuffList::iterator strIt)
 {
-    // fix EOL
-    // change tabulation
-    // remove spaces at EOL
     auto& strBuff = *strIt;
+    std::string outstr;
     for (size_t n = 0; n < strBuff->m_strOffsetList.size(); ++n)
     {
-        auto str{ strBuff->GetStr(n) };
-        std::u16string wstr;
-        bool rc = m_converter->Convert(str, wstr);
-
-        std::string outstr;
-        outstr.reserve(str.size());
-
-        bool changed{};
-        size_t usedSize{};//size of string without of trailing spaces
-        size_t wpos{};
-        size_t i;
-        for (i = 0; i < str.size(); ++i)
+        if (ImproveStr(strBuff->GetStr(n), outstr))
         {
-            unsigned char c = str[i];
-            if (c > ' ')
-            {
-                outstr += c;
-                usedSize = outstr.size();
-            }
-            else if (c == ' ')
-                outstr += ' ';
-            else if (c == S_TAB)
+            _assert(strBuff->GetStr(n) != outstr);
+
+            bool rc = strBuff->ChangeStr(n, outstr);
+            if (!rc)
             {
-                if (m_saveTab)
-                    outstr += S_TAB;
-                else
+                rc = m_buffer.SplitBuff(strIt, n);
+                if (!rc)
                 {
-                    //change tab with space
-                    wpos = wstr.find(S_TAB, wpos);
-                    if (wpos == std::string::npos)
-                    {
-                        _assert(0);
-                    }
-                    else
-                    {
-                        auto tabs = m_tab - (wpos + m_tab) % m_tab;
-                        outstr.append(tabs, ' ');
-                        changed = true;
-                    }
+                    //error
+                    _assert(0);
+                    throw std::runtime_error{ "SplitBuff" };
                 }
             }
+        }
+    }
+
+    return true;
+}
+
+bool Editor::ImproveStr(std::string_view str, std::string& outstr)
+{
+    // fix EOL
+    // change tabulation
+    // remove spaces at EOL
+    std::u16string wstr;
+    m_converter->Convert(str, wstr);
+
+    outstr.clear();
+    outstr.reserve(str.size());
+
+    bool changed{};
+    size_t usedSize{};//size of string without of trailing spaces
+    size_t wpos{};
+    size_t i;
+    for (i = 0; i < str.size(); ++i)
+    {
+        unsigned char c = str[i];
+        if (c > ' ')
+        {
+            outstr += c;
+            usedSize = outstr.size();
+        }
+        else if (c == ' ')
+            outstr += ' ';
+        else if (c == S_TAB)
+        {
+            if (m_saveTab)
+                outstr += S_TAB;
             else
             {
-                if (usedSize != outstr.size())
+                //change tab with space
+                wpos = wstr.find(S_TAB, wpos);
+                if (wpos == std::string::npos)
+                {
+                    _assert(0);
+                }
+                else
                 {
-                    //del all spaces at the end of string
-                    outstr.resize(usedSize);
+                    auto tabs = m_tab - (wpos + m_tab) % m_tab;
+                    outstr.append(tabs, ' ');
                     changed = true;
                 }
-                break;
             }
         }
-        
-        if (m_eol == eol_t::unix_eol)
-        {
-            outstr += S_LF;
-            if (i != str.size() - 1 || str[i] != S_LF)
-                changed = true;
-        }
-        else if (m_eol == eol_t::win_eol)
-        {
-            outstr += "\r\n";
-            if (i != str.size() - 2 || (str[i] != S_CR || str[i + 1] != S_LF))
-                changed = true;
-        }
         else
         {
-            outstr += S_CR;
-            if (i != str.size() - 1 || str[i] != S_CR)
-                changed = true;
-        }
-
-        if (changed)
-        {
-            _assert(str != outstr);
-            changed = false;
-
-            rc = strBuff->ChangeStr(n, outstr);
-            if (!rc)
+            if (usedSize != outstr.size())
             {
-                rc = m_buffer.SplitBuff(strIt, n);
-                if (!rc)
-                {
-                    //error
-                    _assert(0);
-                    throw std::runtime_error{ "SplitBuff" };
-                }
+                //del all spaces at the end of string
+                outstr.resize(usedSize);
+                changed = true;
             }
+            break;
         }
     }
 
-    return true;
+    if (m_eol == eol_t::unix_eol)
+    {
+        outstr += S_LF;
+        if (i != str.size() - 1 || str[i] != S_LF)
+            changed = true;
+    }
+    else if (m_eol == eol_t::win_eol)
+    {
+        outstr += "\r\n";
+        if (i != str.size() - 2 || (str[i] != S_CR || str[i + 1] != S_LF))
+            changed = true;
+    }
+    else
+    {
+        outstr += S_CR;
+        if (i != str.size() - 1 || str[i] != S_CR)
+            changed = true;
+    }
+
+
+    return changed;
 }
 
 std::list<FrameWnd*> Editor::GetLinkedWnd(FrameWnd* wnd) const
@@ -1727,6 +3304,7 @@ std::list<FrameWnd*> Editor::GetLinkedWnd(FrameWnd* wnd) const
 
 bool Editor::SetName(const std::filesystem::path& file, bool copy)
 {
+    WaitSave();
     if(copy)
         std::filesystem::copy(m_file, file, std::filesystem::copy_options::overwrite_existing);
     if (!std::filesystem::exists(file))
@@ -1734,6 +3312,9 @@ bool Editor::SetName(const std::filesystem::path& file, bool copy)
         std::ofstream create(file);
     }
 
+    //journal is bound to file path and its state
+    m_journal.Close(true);
+    m_journalOff = false;
     m_file = file;
     return true;
 }
@@ -1743,26 +3324,75 @@ bool Editor::SetParseStyle(const std::string& style)
     if (style != GetParseStyle())
     {
         LOG(DEBUG) << "Change parse mode to " << style;
+        //lexical parser needs all strings and it must not be used in background
+        WaitIndex();
+        StopLex();
 
         m_lexParser.SetParseStyle(style);
+        m_improveAll |= m_tab != m_lexParser.GetTabSize() || m_saveTab != m_lexParser.GetSaveTab();
         m_tab = m_lexParser.GetTabSize();
         m_saveTab = m_lexParser.GetSaveTab();
 
         FlushCurStr();
         for (size_t n = 0; n < GetStrCount(); ++n)
         {
-            auto str = m_buffer.GetStr(n);
-            m_lexParser.ScanStr(n, str, m_cp);
+            auto str = GetBuffStr(n);
+            LexStr(m_lexParser, n, str);
         }
     }
     
     return true;
 }
 
+bool Editor::Watch()
+{
+    if (IsWatched())
+        return true;
+
+    Unwatch();
+    m_watch = FileWatcher::getInstance().Add(m_file);
+    m_watchPath = m_file;
+    return m_watch != FileWatcher::c_invalid;
+}
+
+void Editor::Unwatch()
+{
+    if (m_watch != FileWatcher::c_invalid)
+        FileWatcher::getInstance().Remove(m_watch);
+    m_watch = FileWatcher::c_invalid;
+    m_watchEvents = watch_none;
+}
+
+bool Editor::IsFileEvent()
+{
+    if (IsWatched())
+        m_watchEvents |= FileWatcher::getInstance().TakeEvents(m_watch);
+    return m_watchEvents != watch_none;
+}
+
+void Editor::CheckMapping() const
+{
+    if (m_mapFile.IsTruncated())
+    {
+        LOG(ERROR) << __FUNC__ << " file was truncated by other process " << m_file.u8string();
+        throw std::runtime_error{"file truncated " + m_file.u8string()};
+    }
+}
+
 file_state Editor::CheckFile()
 {
+    //notification is lost with deleted or renamed file and set again for new one
+    if ((m_watchEvents & watch_removed) || (m_watch != FileWatcher::c_invalid && m_watchPath != m_file))
+        Unwatch();
+    m_watchEvents = watch_none;
+
     if (!std::filesystem::exists(m_file))
         return file_state::removed;
+    if (m_watch == FileWatcher::c_invalid)
+        Watch();
+    if (m_mapFile.IsTruncated())
+        //not modified strings were read as zeros
+        return file_state::changed;
     
     auto size = std::filesystem::file_size(m_file);
     auto time = std::filesystem::last_write_time(m_file);
@@ -1776,8 +3406,24 @@ file_state Editor::CheckFile()
     return file_state::not_changed;
 }
 
+bool Editor::IsFileModified() const
+{
+    std::error_code ec;
+    auto size = std::filesystem::file_size(m_file, ec);
+    if (ec)
+        return true;
+    auto time = std::filesystem::last_write_time(m_file, ec);
+    return ec || size != m_fileSize || time != m_fileTime;
+}
+
 bool Editor::IsFileInMemory()
 {
+    if (m_usePieces)
+        //original strings are only in mapped file
+        return false;
+
+    WaitIndex();
+
     for (auto& buff : m_buffer.m_buffList)
     {
         auto ptr = buff->GetBuff();
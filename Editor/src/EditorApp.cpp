@@ -47,12 +47,16 @@ bool EditorApp::Init()
 {
     Application::Init();
     SetStatusLine(g_statusLine);
+
+    //changes of watched files are processed at once in main loop
+    FileWatcher::getInstance().SetNotify([this]() { WakeInput(); });
     return true;
 }
 
 void EditorApp::Deinit()
 {
     CloseAllWindows();
+    FileWatcher::getInstance().SetNotify(nullptr);
     Application::Deinit();
 }
 
@@ -221,7 +225,12 @@ bool EditorApp::CloseWindow(Wnd* wnd)
     if(auto it = m_editors.find(wnd); it != m_editors.end())
     {
         //LOG(DEBUG) << "CloseWindows " << wnd;
+        auto path = it->second->GetFilePath();
         m_editors.erase(it);
+
+        //stream spooling is stopped with the last window
+        if (IsStream(path) && !GetEditorWnd(path))
+            m_streams.remove_if([&path](const std::unique_ptr<StreamSpool>& stream) {return stream->GetPath() == path;});
         return true;
     }
 
@@ -238,6 +247,12 @@ Wnd* EditorApp::GetEditorWnd(std::filesystem::path path)
     return nullptr;
 }
 
+bool EditorApp::IsStream(const std::filesystem::path& path) const
+{
+    return std::any_of(m_streams.cbegin(), m_streams.cend(),
+        [&path](const std::unique_ptr<StreamSpool>& stream) {return stream->GetPath() == path;});
+}
+
 bool EditorApp::CloseAllWindows()
 {
     for (auto& [ptr, wnd] : m_editors)
@@ -252,6 +267,8 @@ bool EditorApp::CloseAllWindows()
         );
         if (ret == ID_OK)
             wnd->Save(0);
+        else
+            wnd->DiscardChanges();
     }
 
     m_editors.clear();
@@ -338,6 +355,9 @@ bool EditorApp::OpenFile(const std::filesystem::path& path, const std::string& p
         editor->SetRO(ro);
         editor->SetLog(log);
         m_editors[editor.get()] = editor;
+        if (IsStream(fullPath))
+            //spool file exists only while editor is running
+            return true;
 
         m_recentFiles.erase(std::remove_if(m_recentFiles.begin(), m_recentFiles.end(),
             [&fullPath](const file_t& file) {return std::get<0>(file) == fullPath;}), m_recentFiles.end());
@@ -393,6 +413,90 @@ bool EditorApp::LoadCfg()
     return true;
 }
 
+bool EditorApp::OpenStream(int fd, const std::string& name)
+{
+    //stream data is spooled to temporary file and shown as growing log
+    auto dir = Directory::TmpPath("m");
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    auto stream = std::make_unique<StreamSpool>();
+    if (!stream->Open(fd, dir, name))
+    {
+        EditorApp::SetErrorLine("Error stream opening");
+        return false;
+    }
+
+    //the first part of data is shown at once if it is ready
+    stream->WaitData(c_streamWait);
+    auto spoolPath = std::filesystem::canonical(stream->GetPath());
+    m_streams.push_back(std::move(stream));
+
+    //saving would replace spool file while data is appended to it, so only Save As is possible
+    auto [t, parser] = LexParser::GetFileType(spoolPath);
+    bool rc = OpenFile(spoolPath, parser, "UTF-8", true, true);
+    if (!GetEditorWnd(spoolPath))
+        m_streams.pop_back();
+    return rc;
+}
+
+bool EditorApp::RecoverFiles() try
+{
+    auto dir{ Editor::GetJournalDir() };
+    std::error_code ec;
+    if (!std::filesystem::is_directory(dir, ec))
+        return true;
+
+    std::vector<std::filesystem::path> journals;
+    for (auto& entry : std::filesystem::directory_iterator(dir, ec))
+        if (entry.path().extension() == ".jrn")
+            journals.push_back(entry.path());
+
+    for (auto& journal : journals)
+    {
+        //journal of editor in other instance is locked
+        if (EditJournal::IsLocked(journal))
+            continue;
+
+        //journal is applied only to the same file as it was before changes
+        EditJournal::Header header;
+        std::filesystem::path path;
+        bool valid = EditJournal::Read(journal, header);
+        if (valid)
+        {
+            path = std::filesystem::u8path(header.filePath);
+            auto size = std::filesystem::file_size(path, ec);
+            auto time = ec ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(path, ec);
+            valid = !ec && size == header.fileSize && time.time_since_epoch().count() == header.fileTime;
+        }
+
+        if (valid)
+        {
+            auto ret = MsgBox(MBoxKey::OK_CANCEL, "Recovery: " + path.filename().u8string(),
+                { "File was not saved before crash of editor.",
+                "Do you want to restore changes ?" },
+                { "Restore", "No" }
+            );
+            if (ret == ID_OK && OpenFile(path, header.parseStyle, header.cp))
+            {
+                if (auto wnd = GetEditorWnd(std::filesystem::canonical(path)))
+                    m_editors[wnd]->Recover(journal);
+                continue;
+            }
+        }
+
+        LOG(DEBUG) << __FUNC__ << " remove " << journal.u8string();
+        std::filesystem::remove(journal, ec);
+    }
+
+    return true;
+}
+catch (const std::exception& ex)
+{
+    LOG(ERROR) << __FUNC__ << " exception: " << ex.what();
+    return false;
+}
+
 bool EditorApp::SaveCfg(input_t code)
 { 
     //configuration saving
@@ -418,6 +522,9 @@ bool EditorApp::SaveSession(std::optional<const std::filesystem::path> path)
     SessionConfig sesConfig;
     for (auto& [w, wnd] : m_editors)
     {
+        if (IsStream(wnd->GetFilePath()))
+            continue;
+
         WndConfig config;
         if (!wnd->SaveCfg(config))
             continue;
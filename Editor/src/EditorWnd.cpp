@@ -200,6 +200,7 @@ bool EditorWnd::_GotoXY(size_t x, size_t y, bool top)
     size_t line{};
     size_t pos{};
 
+    m_editor->WaitIndex(y);
     if (y > m_editor->GetStrCount())
         y = m_editor->GetStrCount();
 
@@ -639,6 +640,31 @@ input_t EditorWnd::EventProc(input_t code)
         //check for file changing by external program
         if (WndManager::getInstance().IsVisible(this))
             CheckFileChanging();
+
+        //lexical positions scanned in background are needed only for coloring
+        m_editor->UpdateLex();
+
+        //access mark is updated after saving in background
+        if (m_editor->UpdateSave())
+        {
+            for (auto& wnd : m_editor->GetLinkedWnd())
+                reinterpret_cast<EditorWnd*>(wnd)->UpdateAccessInfo();
+        }
+
+        //journal is written to disk in batches
+        m_editor->FlushJournal();
+        AutoSave();
+
+        //show strings indexed in background
+        if (m_editor->UpdateIndex())
+        {
+            for (auto& wnd : m_editor->GetLinkedWnd())
+            {
+                auto editorWnd = reinterpret_cast<EditorWnd*>(wnd);
+                editorWnd->InvalidateRect(0, 0, editorWnd->m_clientSizeX, editorWnd->m_clientSizeY);
+                editorWnd->Repaint();
+            }
+        }
     }
 
     if ( code != K_TIME
@@ -1749,6 +1775,7 @@ bool EditorWnd::FindDown(bool silence)
         }
 
     //search diaps
+    m_editor->WaitIndex();
     size_t line{ m_firstLine + m_cursory };
     size_t end{m_editor->GetStrCount()};
     if (FindDialog::s_vars.inSelected && m_selectState == select_state::complete)
@@ -2029,12 +2056,17 @@ bool EditorWnd::TryDeleteSelectedBlock()
 bool EditorWnd::CheckFileChanging() try
 {
     bool rc{true};
-    if (!m_untitled && m_checkTime <= std::chrono::system_clock::now())
+    //file with notification is checked only on its events, others are polled
+    bool check{ m_editor->IsWatched() ? m_editor->IsFileEvent() : m_checkTime <= std::chrono::system_clock::now() };
+    if (!m_untitled && check)
     {
         //LOG(DEBUG) << "CheckFileChanging";
         m_checkTime = std::chrono::system_clock::now() + std::chrono::seconds(m_log ? LogFileCheckInterval : FileCheckInterval);
 
         auto state = m_editor->CheckFile();
+        if (m_log && state == file_state::removed && std::filesystem::exists(m_editor->GetFilePath()))
+            //truncated log is loaded again
+            state = file_state::changed;
         if (state == file_state::removed)
         {
             //file was deleted
@@ -2098,7 +2130,7 @@ bool EditorWnd::CheckFileChanging() try
                         else
                             editorWnd->MoveDown(static_cast<uint16_t>(step));
                     }
-                    editorWnd->InvalidateRect(0, 0, m_clientSizeX, m_clientSizeY);
+                    editorWnd->InvalidateRect(0, 0, editorWnd->m_clientSizeX, editorWnd->m_clientSizeY);
                     editorWnd->Repaint();
                 }
             }
@@ -2127,6 +2159,30 @@ catch (const std::exception& ex)
     return false;
 }
 
+bool EditorWnd::AutoSave() try
+{
+    auto changeTime = m_editor->GetChangeTime();
+    if (!g_editorConfig.fileSaveTime || !changeTime || m_untitled || m_readOnly || m_log || m_deleted
+        || !m_editor->IsChanged() || m_editor->IsSaving()
+        || time(nullptr) - changeTime < static_cast<time_t>(g_editorConfig.fileSaveTime))
+        return false;
+
+    //file changed by somebody else is not overwritten without asking of user
+    if (m_editor->IsFileModified())
+        return false;
+
+    LOG(DEBUG) << "    AutoSave " << GetFilePath().u8string();
+    [[maybe_unused]]bool rc = m_editor->Save(true);
+    UpdateAccessInfo();
+    return true;
+}
+catch (const std::exception& ex)
+{
+    LOG(ERROR) << __FUNC__ << "exception:" << ex.what();
+    EditorApp::SetErrorLine("File autosave error");
+    return false;
+}
+
 bool EditorWnd::SaveCfg(WndConfig& config)
 {
     if (m_untitled)
@@ -37,6 +37,7 @@ namespace _Editor
 
 bool EditorWnd::DlgGoto([[maybe_unused]]input_t cmd)
 {
+    m_editor->WaitIndex();
     GotoDialog dlg(m_editor->GetStrCount());
     auto ret = dlg.Activate();
     if (ret == ID_OK)
@@ -154,6 +155,7 @@ bool EditorWnd::CtrlProperties([[maybe_unused]]input_t cmd)
     PropertiesDialog::s_vars.replaceTab = !m_editor->GetSaveTab();
     PropertiesDialog::s_vars.showTab    = m_editor->GetShowTab();
     PropertiesDialog::s_vars.typeName   = m_editor->GetParseStyle();
+    m_editor->LogMemStat();
 
     PropertiesDialog dlg;
     auto ret = dlg.Activate();
@@ -718,6 +718,16 @@ bool EditorWnd::Reload([[maybe_unused]]input_t cmd)
     return rc;
 }
 
+bool EditorWnd::Recover(const std::filesystem::path& journal)
+{
+    LOG(DEBUG) << "    Recover " << journal.u8string();
+
+    bool rc = m_editor->Recover(journal);
+    UpdateAccessInfo();
+    Refresh();
+    return rc;
+}
+
 bool EditorWnd::Close([[maybe_unused]]input_t cmd)
 {
     m_close = true;
@@ -747,6 +757,7 @@ bool EditorWnd::Replace([[maybe_unused]] input_t cmd)
     WndManager::getInstance().Refresh();
 
     size_t begin = m_firstLine + m_cursory;
+    m_editor->WaitIndex();
     size_t strCount = m_editor->GetStrCount();
     
     bool userBreak{};
@@ -912,7 +923,8 @@ bool EditorWnd::Save(input_t cmd)
 
     try
     {
-        [[maybe_unused]]bool rc = m_editor->Save();
+        //file is written in background, it is finished by timer
+        [[maybe_unused]]bool rc = m_editor->Save(true);
     }
     catch (const std::exception& ex)
     {
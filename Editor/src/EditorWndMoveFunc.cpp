@@ -225,6 +225,8 @@ bool EditorWnd::MoveDown(input_t cmd)
 
     if (m_firstLine != line)
     {
+        //wait for indexing of next screen
+        m_editor->WaitIndex(line + m_clientSizeY);
         size_t numLine = m_editor->GetStrCount();
         if (line < numLine - m_clientSizeY / 4)
         {
@@ -347,6 +349,7 @@ bool EditorWnd::MovePageUp([[maybe_unused]]input_t cmd)
 
 bool EditorWnd::MovePageDown([[maybe_unused]]input_t cmd)
 {
+    m_editor->WaitIndex(m_firstLine + 2 * m_clientSizeY);
     size_t numLine = m_editor->GetStrCount();
     if (m_firstLine + m_clientSizeY - 1 < numLine)
     {
@@ -379,6 +382,7 @@ bool EditorWnd::MoveFileBegin([[maybe_unused]]input_t cmd)
 bool EditorWnd::MoveFileEnd(input_t cmd)
 {
     size_t saveX = K_GET_CODE(cmd);
+    m_editor->WaitIndex();
     size_t numLine = m_editor->GetStrCount();
 
     size_t line = 0;
@@ -845,6 +849,7 @@ bool EditorWnd::SelectAll(input_t cmd)
         SelectUnselect(cmd);
 
     m_beginY = 0;
+    m_editor->WaitIndex();
     m_endY = m_editor->GetStrCount() - 1;
     m_beginX = 0;
     m_endX = m_editor->GetMaxStrLen();
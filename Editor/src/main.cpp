@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "utils/logger.h"
 #include "utils/Directory.h"
+#include "utils/MemBuff.h"
 #include "utfcpp/utf8.h"
 #include "cxxopts/cxxopts.hpp"
 #include "EditorApp.h"
@@ -38,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include <filesystem>
+#include <cstdio>
 
 using namespace _Editor;
 
@@ -97,6 +99,7 @@ int main(int argc, char** argv) try
 {
     auto tmpPath = _Utils::Directory::TmpPath("m");
     auto log = tmpPath / "m-%datetime{%Y%M%d}.log";
+    _Utils::BuffPool<std::string>::s_pool.SetSwapPath(tmpPath);
 
     ConfigureLogger(log.u8string());
     LOG(INFO);
@@ -108,6 +111,7 @@ int main(int argc, char** argv) try
         ("k,keys", "Print key map combinations")
         ("c,config", "Save default config files")
         ;
+    options.positional_help("[FILE...] ('-' for reading stdin)");
 
     auto result = options.parse(argc, argv);
     if (result.count("help"))
@@ -142,6 +146,13 @@ int main(int argc, char** argv) try
     {
         for (auto& f : files)
         {
+            if (f == "-")
+            {
+                //piped input: cmd | m -
+                app.OpenStream(fileno(stdin), "stdin");
+                continue;
+            }
+
             std::filesystem::path path = utf8::utf8to16(f);
             auto [t, parser] = LexParser::GetFileType(path);
             app.OpenFile(f, parser, "UTF-8");
@@ -149,6 +160,8 @@ int main(int argc, char** argv) try
     }
     else
         _TRY(app.LoadSession(std::nullopt));
+    //changes not saved before crash are offered after all files are opened
+    app.RecoverFiles();
 
     app.MainProc(K_EXIT);
     app.Deinit();
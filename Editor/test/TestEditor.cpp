@@ -0,0 +1,129 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifdef USE_VLD
+  #include <vld.h>
+#endif
+
+#include "utils/logger.h"
+#include "utils/Directory.h"
+#include "EditJournal.h"
+
+#include <iostream>
+#include <filesystem>
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////////
+using namespace _Utils;
+using namespace _Editor;
+
+void EditJournalTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto path = Directory::TmpPath("m") / "m-journal.jrn";
+    std::filesystem::create_directories(path.parent_path());
+    EditJournal::Header header{ "/tmp/file.txt", 12345, 67890, "UTF-8", "Text" };
+
+    std::vector<EditCmd> cmds;
+    cmds.push_back({ cmd_t::CMD_ADD_LINE, 10, 0, 5, 0, u"added" });
+    cmds.push_back({ cmd_t::CMD_CHANGE_SUBSTR, 3, 7, 2, 0, u"xy" });
+    cmds.push_back({ cmd_t::CMD_DEL_LINE, 100, 0, 0, 3, u"" });
+    cmds.push_back({ cmd_t::CMD_SPLIT_LINE, 0x100000000, 1, 0, 0, u"\u0444\u0430\u0439\u043b" });
+    auto same = [](const EditCmd& a, const EditCmd& b) {
+        return a.command == b.command && a.line == b.line && a.pos == b.pos && a.len == b.len && a.count == b.count
+            && a.str == b.str.substr(0, b.len);
+    };
+
+    EditJournal journal;
+    _assert(journal.Open(path, header) && EditJournal::IsLocked(path));
+    for (auto& cmd : cmds)
+    {
+        journal.Add(cmd.command, cmd.line, cmd.pos, cmd.count, cmd.len, cmd.str);
+        //not changing commands are skipped
+        journal.Add(cmd_t::CMD_BEGIN, 0, 0, 0, 0, u"");
+    }
+    _assert(journal.Flush());
+
+    EditJournal::Header readHeader;
+    std::vector<EditCmd> readCmds;
+    _assert(EditJournal::Read(path, readHeader, &readCmds));
+    _assert(readHeader.filePath == header.filePath && readHeader.fileSize == header.fileSize
+        && readHeader.fileTime == header.fileTime && readHeader.cp == header.cp && readHeader.parseStyle == header.parseStyle);
+    _assert(readCmds.size() == cmds.size());
+    for (size_t i = 0; i < readCmds.size() && i < cmds.size(); ++i)
+        _assert(same(readCmds[i], cmds[i]));
+
+    //journal is kept by close without removing
+    journal.Close();
+    _assert(!EditJournal::IsLocked(path) && std::filesystem::exists(path));
+
+    //torn tail after crash, the last record is dropped
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 3);
+    readCmds.clear();
+    _assert(EditJournal::Read(path, readHeader, &readCmds) && readCmds.size() == cmds.size() - 1);
+    for (size_t i = 0; i < readCmds.size(); ++i)
+        _assert(same(readCmds[i], cmds[i]));
+
+    //broken header
+    std::filesystem::resize_file(path, 10);
+    _assert(!EditJournal::Read(path, readHeader));
+
+    //commands after mark stay in journal of saved file
+    _assert(journal.Open(path, header));
+    journal.Add(cmds[0].command, cmds[0].line, cmds[0].pos, cmds[0].count, cmds[0].len, cmds[0].str);
+    journal.Mark();
+    journal.Add(cmds[1].command, cmds[1].line, cmds[1].pos, cmds[1].count, cmds[1].len, cmds[1].str);
+    header.fileSize = 54321;
+    _assert(journal.Rebase(header) && journal.IsOpen());
+    readCmds.clear();
+    _assert(EditJournal::Read(path, readHeader, &readCmds) && readHeader.fileSize == header.fileSize);
+    _assert(readCmds.size() == 1 && same(readCmds[0], cmds[1]));
+
+    //saved without later changes
+    journal.Mark();
+    _assert(journal.Rebase(header) && !journal.IsOpen() && !std::filesystem::exists(path));
+
+    _assert(journal.Open(path, header));
+    journal.Close(true);
+    _assert(!std::filesystem::exists(path));
+}
+
+int main()
+{
+    ConfigureLogger("m-%datetime{%Y%M%d}.log", 0x200000, false);
+    LOG(INFO);
+    LOG(INFO) << "Editor test";
+    std::cout << "Editor test starts...";
+
+    EditJournalTest();
+
+    std::cout << "Editor test finished";
+    LOG(INFO) << "End";
+
+    return 0;
+}
@@ -0,0 +1,363 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/logger.h"
+#include "utils/MemBuff.h"
+#include "utils/PieceTable.h"
+#include "utils/Lz.h"
+#include "utils/StrScan.h"
+#include "utils/SymbolType.h"
+#include "utils/CpConverter.h"
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cerrno>
+
+/////////////////////////////////////////////////////////////////////////////
+using namespace _Utils;
+
+//benchmarks only log their numbers, behaviour is checked in TestUtils
+void GapBuffBench()
+{
+    LOG(DEBUG) << "Bench: " << __FUNC__;
+
+    //typing of Enter in the middle of dense block
+    auto typing = [](bool gap) {
+        auto sbuff = std::make_unique<StrBuff<std::string, std::string_view>>();
+        sbuff->GetBuff();
+        for (int i = 0; i < 1000; ++i)
+            sbuff->AppendStr("0123456789012345678901234567890123456789\n");
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            sbuff->AddStr(500 + i, "\n");
+            sbuff->ChangeStr(500 + i, "a\n");
+            if (!gap)
+                //continuous data as without gap
+                sbuff->CloseGap();
+        }
+        auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        [[maybe_unused]] auto str = sbuff->GetStr(10499);
+        _assert(sbuff->GetStrCount() == 11000 && str == "a\n");
+        return time;
+    };
+
+    auto t1 = typing(false);
+    auto t2 = typing(true);
+    LOG(INFO) << "SBuff typing continuous=" << t1 << "us gap=" << t2 << "us";
+}
+
+void StorageBench()
+{
+    LOG(DEBUG) << "Bench: " << __FUNC__;
+
+    using namespace std::chrono;
+    std::string orig;
+    std::vector<uint64_t> strEnd;
+    for (int i = 0; i < 200000; ++i)
+    {
+        orig += "benchmark string " + std::to_string(i) + "\n";
+        strEnd.push_back(orig.size());
+    }
+
+    auto edit = [](auto& buff) {
+        std::mt19937 gen{1};
+        for (int i = 0; i < 20000; ++i)
+        {
+            auto op = gen() % 3;
+            size_t n = gen() % buff.GetStrCount();
+            if (op == 0)
+                buff.AddStr(n, "added string\n");
+            else if (op == 1)
+                buff.ChangeStr(n, "changed string\n");
+            else
+                buff.DelStr(n);
+        }
+    };
+
+    //block storage
+    auto t0 = steady_clock::now();
+    MemStrBuff<std::string, std::string_view> mbuff;
+    uint64_t begin{};
+    for (auto end : strEnd)
+    {
+        mbuff.AppendStr(std::string_view(orig).substr(begin, end - begin));
+        begin = end;
+    }
+    auto t1 = steady_clock::now();
+    edit(mbuff);
+    auto t2 = steady_clock::now();
+    std::string data1;
+    data1.reserve(orig.size());
+    for (size_t i = 0; i < mbuff.GetStrCount(); ++i)
+        data1 += mbuff.GetStr(i);
+    auto t3 = steady_clock::now();
+
+    //piece table
+    PieceTable<std::string, std::string_view> table;
+    table.SetOriginal(orig);
+    for (auto end : strEnd)
+        table.AppendOriginalStr(end);
+    auto t4 = steady_clock::now();
+    edit(table);
+    auto t5 = steady_clock::now();
+    std::string data2;
+    data2.reserve(orig.size());
+    table.ForEachPart([&data2](std::string_view part) { data2 += part; return true; });
+    auto t6 = steady_clock::now();
+
+    _assert(data1 == data2);
+
+    auto ms = [](auto t) { return duration_cast<milliseconds>(t).count(); };
+    LOG(INFO) << "MemStrBuff load=" << ms(t1 - t0) << "ms edit=" << ms(t2 - t1) << "ms save=" << ms(t3 - t2) << "ms";
+    LOG(INFO) << "PieceTable load=" << ms(t4 - t3) << "ms edit=" << ms(t5 - t4) << "ms save=" << ms(t6 - t5) << "ms";
+}
+
+void LzBench()
+{
+    LOG(DEBUG) << "Bench: " << __FUNC__;
+
+    //typical log block
+    std::mt19937 gen{1};
+    std::string text;
+    for (int i = 0; text.size() < BUFF_SIZE - 100; ++i)
+        text += "2021-03-" + std::to_string(10 + i % 20) + " 12:" + std::to_string(10 + i % 50)
+            + " [INFO] request id=" + std::to_string(gen() % 100000) + " status=200 time=" + std::to_string(gen() % 1000) + "ms\n";
+
+    std::string packed;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i)
+        Lz::Compress(text.data(), text.size(), packed);
+    auto packTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::string unpacked(text.size(), 0);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i)
+        Lz::Decompress(packed.data(), packed.size(), unpacked.data(), unpacked.size());
+    auto unpackTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    LOG(INFO) << "Lz block=" << text.size() << " packed=" << packed.size()
+        << " pack=" << packTime / 100 << "us unpack=" << unpackTime / 100 << "us";
+}
+
+void BlockSizeBench()
+{
+    LOG(DEBUG) << "Bench: " << __FUNC__;
+
+    using namespace std::chrono;
+    auto ms = [](auto t) { return duration_cast<milliseconds>(t).count(); };
+
+    std::string first;
+    for (size_t blockSize = BUFF_SIZE; blockSize <= MAX_BUFF_SIZE; blockSize *= 4)
+    {
+        auto t0 = steady_clock::now();
+        MemStrBuff<std::string, std::string_view> mbuff;
+        mbuff.SetBlockSize(blockSize);
+        for (int i = 0; i < 500000; ++i)
+            mbuff.AppendStr("block size benchmark string " + std::to_string(i) + "\n");
+        auto t1 = steady_clock::now();
+
+        //sequential and random scrolling
+        size_t size{};
+        for (size_t i = 0; i < mbuff.GetStrCount(); ++i)
+            size += mbuff.GetStr(i).size();
+        std::mt19937 gen{1};
+        for (int i = 0; i < 100000; ++i)
+            size += mbuff.GetStr(gen() % mbuff.GetStrCount()).size();
+        auto t2 = steady_clock::now();
+
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto op = gen() % 3;
+            size_t n = gen() % mbuff.GetStrCount();
+            if (op == 0)
+                mbuff.AddStr(n, "added string\n");
+            else if (op == 1)
+                mbuff.ChangeStr(n, "changed string " + std::to_string(i) + "\n");
+            else
+                mbuff.DelStr(n);
+        }
+        auto t3 = steady_clock::now();
+
+        std::string data;
+        for (size_t i = 0; i < mbuff.GetStrCount(); ++i)
+            data += mbuff.GetStr(i);
+        if (first.empty())
+            first = data;
+        _assert(size != 0 && data == first);
+
+        [[maybe_unused]] auto stat = mbuff.GetMemStat();
+        LOG(INFO) << "Block size=" << blockSize / 1024 << "K blocks=" << stat.blocks << " load=" << ms(t1 - t0)
+            << "ms scroll=" << ms(t2 - t1) << "ms edit=" << ms(t3 - t2) << "ms";
+    }
+}
+
+void StrScanBench()
+{
+    LOG(DEBUG) << "Bench: " << __FUNC__;
+
+    std::mt19937 gen{1};
+
+    //load throughput of string scanning like in Editor::ScanStrOffset
+    std::string text;
+    while (text.size() < 0x1000000)
+        text += "2021-03-15 12:" + std::to_string(gen() % 60) + " [INFO]\tserver request id=" + std::to_string(gen())
+            + " status=200 time=" + std::to_string(gen() % 1000) + "ms\n";
+
+    using namespace std::chrono;
+    auto perByte = [&text]() {
+        size_t strings{};
+        size_t cut{};
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            unsigned char ch = text[i];
+            if (ch == '\n' || ch == '\r')
+                ++strings;
+            else if (ch != '\t' && GetSymbolType(ch) != symbol_t::alnum)
+                cut = i;
+        }
+        return cut < text.size() ? strings : 0;
+    };
+    auto bulk = [&text]() {
+        size_t strings{};
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            i += StrScan::FindBreak(text.data() + i, text.size() - i);
+            if (i < text.size() && (text[i] == '\n' || text[i] == '\r'))
+                ++strings;
+        }
+        return strings;
+    };
+
+    auto t0 = steady_clock::now();
+    [[maybe_unused]] auto n1 = perByte();
+    auto t1 = steady_clock::now();
+    [[maybe_unused]] auto n2 = bulk();
+    auto t2 = steady_clock::now();
+    _assert(n1 == n2);
+
+    auto mbs = [&text](auto t) { return text.size() * 1000 / (duration_cast<microseconds>(t).count() + 1) / 1024; };
+    LOG(INFO) << "StrScan " << StrScan::GetImpl() << " per byte=" << mbs(t1 - t0) << "MB/s bulk=" << mbs(t2 - t1) << "MB/s";
+}
+
+//conversion by iconv only, as it was before built-in UTF-8 conversion
+static bool IconvConvert(iconv_t cd, std::string_view str, std::u16string& out)
+{
+    auto srcPtr = str.data();
+    size_t srcSize = str.size();
+    out.resize(srcSize * 2);
+    auto dstPtr = reinterpret_cast<char*>(out.data());
+    size_t dstSize = out.size() * 2;
+    size_t reserv = out.size();
+
+    bool rc{ true };
+    while (srcSize)
+    {
+        if (iconv(cd, &srcPtr, &srcSize, &dstPtr, &dstSize) == static_cast<size_t>(-1))
+        {
+            rc = false;
+            if (errno == EINVAL)
+                break;
+            ++srcPtr;
+            --srcSize;
+            *dstPtr++ = '?';
+            *dstPtr++ = 0;
+            dstSize -= 2;
+        }
+    }
+    out.resize(reserv - dstSize / 2);
+    return rc;
+}
+
+void CpConverterBench()
+{
+    LOG(DEBUG) << "Bench: " << __FUNC__;
+
+    std::mt19937 gen{1};
+    std::u16string out1;
+    std::u16string out2;
+    iconv_t utf8 = iconv_open("UTF-16LE", "UTF-8");
+    iconvpp::CpConverter utf8Conv{ "UTF-8" };
+
+    //throughput on typical source and log strings
+    std::vector<std::string> source;
+    std::vector<std::string> log;
+    std::vector<std::string> text;
+    size_t size{};
+    while (size < 0x1000000)
+    {
+        source.push_back("    for (size_t i = 0; i < m_buffList.size(); ++i)//" + std::to_string(gen()));
+        log.push_back("2021-03-15 12:" + std::to_string(gen() % 60) + " [INFO]\tserver request id=" + std::to_string(gen())
+            + " status=200 time=" + std::to_string(gen() % 1000) + "ms");
+        text.push_back("\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 mixed text " + std::to_string(gen()));
+        size += source.back().size();
+    }
+
+    using namespace std::chrono;
+    auto bench = [&out1](const std::vector<std::string>& strings, const std::function<void(const std::string&)>& convert) {
+        auto t = steady_clock::now();
+        size_t bytes{};
+        for (auto& str : strings)
+        {
+            convert(str);
+            bytes += str.size();
+        }
+        return bytes * 1000 / (duration_cast<microseconds>(steady_clock::now() - t).count() + 1) / 1024;
+    };
+    for (auto strings : { &source, &log, &text })
+    {
+        auto builtin = bench(*strings, [&](const std::string& str) { utf8Conv.Convert(str, out1); });
+        auto reference = bench(*strings, [&](const std::string& str) { IconvConvert(utf8, str, out2); });
+        LOG(INFO) << "CpConverter " << StrScan::GetImpl() << " " << (strings == &source ? "source" : strings == &log ? "log" : "text")
+            << " built-in=" << builtin << "MB/s iconv=" << reference << "MB/s";
+    }
+
+    iconv_close(utf8);
+}
+
+int main()
+{
+    ConfigureLogger("m-%datetime{%Y%M%d}.log", 0x200000, false);
+    LOG(INFO);
+    LOG(INFO) << "Utils bench";
+    std::cout << "Utils bench starts...";
+
+    GapBuffBench();
+    StorageBench();
+    LzBench();
+    BlockSizeBench();
+    StrScanBench();
+    CpConverterBench();
+
+    std::cout << "Utils bench finished";
+    LOG(INFO) << "End";
+
+    return 0;
+}
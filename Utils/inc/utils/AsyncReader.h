@@ -0,0 +1,98 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace _Utils
+{
+
+//positioned file reads with queue of outstanding requests served by thread pool
+//and kernel read-ahead hints
+class AsyncReader
+{
+    struct Request
+    {
+        uint64_t                        offset{};
+        size_t                          size{};
+        std::shared_ptr<std::string>    buff;
+        bool                            started{};
+        bool                            done{};
+    };
+
+#ifdef WIN32
+    void*                   m_file{};
+#else
+    int                     m_file{-1};
+#endif
+    uint64_t                m_size{};
+    size_t                  m_threads;
+
+    std::vector<std::thread> m_workers;
+    std::mutex              m_mutex;
+    std::condition_variable m_queueCond;//new request or stop
+    std::condition_variable m_doneCond; //request is done
+    std::deque<std::shared_ptr<Request>> m_queue;
+    bool                    m_stop{};
+
+    void    Worker();
+
+public:
+    explicit AsyncReader(size_t threads = 2) : m_threads{threads ? threads : 1} {}
+    AsyncReader(const AsyncReader&) = delete;
+    void operator= (const AsyncReader&) = delete;
+    ~AsyncReader() { Close(); }
+
+    bool    Open(const std::filesystem::path& file, bool sequential = false);
+    void    Close();
+#ifdef WIN32
+    bool    IsOpen() const  { return m_file != nullptr; }
+#else
+    bool    IsOpen() const  { return m_file >= 0; }
+#endif
+    uint64_t GetSize() const { return m_size; }
+
+    //synchronous read, return number of read bytes
+    size_t  Read(uint64_t offset, size_t size, char* buff) const;
+    //hint for kernel to read range in background
+    void    Prefetch(uint64_t offset, size_t size) const;
+
+    //requests are completed in any order, but taken in order of queueing
+    bool    Queue(uint64_t offset, size_t size);
+    //wait for the first queued request, return number of read bytes or 0 if queue is empty
+    size_t  Wait(std::shared_ptr<std::string>& buff);
+};
+
+} //namespace _Utils
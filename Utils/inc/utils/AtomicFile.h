@@ -0,0 +1,84 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <filesystem>
+#include <cstdint>
+
+namespace _Utils
+{
+
+//crash-safe replacing of file: new content is written to temporary file in the same directory,
+//not changed ranges are copied from original file in kernel, then temporary file is synced and renamed.
+//Open fails for links and for files whose owner can't be kept, then caller overwrites file in place
+class AtomicFile
+{
+    inline static const size_t c_copySize{ 0x100000 };
+    inline static const unsigned c_tmpTries{ 16 };
+
+#ifdef WIN32
+    void*                   m_src{};
+    void*                   m_dst{};
+#else
+    int                     m_src{-1};
+    int                     m_dst{-1};
+#endif
+    std::filesystem::path   m_path;
+    std::filesystem::path   m_tmpPath;
+    uint64_t                m_size{};
+
+    bool    CopyByRead(uint64_t offset, uint64_t size);
+    std::filesystem::path GetTmpName(unsigned seed) const;
+
+public:
+    AtomicFile() = default;
+    AtomicFile(const AtomicFile&) = delete;
+    void operator= (const AtomicFile&) = delete;
+    ~AtomicFile() { Discard(); }
+
+    bool    Open(const std::filesystem::path& path);
+    //append data to new file
+    bool    Write(const char* data, size_t size);
+    //append range of original file to new file
+    bool    Copy(uint64_t offset, uint64_t size);
+    //flush new file to disk, it can be done in other thread before commit
+    bool    Sync();
+    //sync new file and replace original one
+    bool    Commit();
+    //remove new file, original file is not changed
+    void    Discard();
+
+#ifdef WIN32
+    bool    IsOpen() const  { return m_dst != nullptr; }
+#else
+    bool    IsOpen() const  { return m_dst >= 0; }
+#endif
+    uint64_t GetSize() const { return m_size; }
+    const std::filesystem::path& GetTmpPath() const { return m_tmpPath; }
+};
+
+} //namespace _Utils
@@ -0,0 +1,345 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+
+namespace _Utils
+{
+
+//ordered sequence stored as AVL tree without keys (like std::list)
+//every node keeps summary weight of its subtree (for example number of lines),
+//so we can find element by accumulated weight in O(log n).
+//iterators are not invalidated by insert/erase of another elements.
+//if weight of element was changed outside call Update() for it.
+template <typename T, typename Tweight>
+class BuffTree
+{
+    struct Node
+    {
+        T       value;
+        Node*   parent{};
+        Node*   left{};
+        Node*   right{};
+        int     height{1};
+        size_t  weight{};//weight of subtree
+
+        Node(const T& v) : value{v} {}
+    };
+
+    Node*   m_root{};
+    size_t  m_size{};
+    Tweight m_weight{};
+
+    static int      Height(const Node* n) { return n ? n->height : 0; }
+    static size_t   Weight(const Node* n) { return n ? n->weight : 0; }
+
+    static Node* Leftmost(Node* n)
+    {
+        while (n && n->left)
+            n = n->left;
+        return n;
+    }
+
+    static Node* Rightmost(Node* n)
+    {
+        while (n && n->right)
+            n = n->right;
+        return n;
+    }
+
+    static Node* Next(Node* n)
+    {
+        if (n->right)
+            return Leftmost(n->right);
+        while (n->parent && n->parent->right == n)
+            n = n->parent;
+        return n->parent;
+    }
+
+    static Node* Prev(Node* n)
+    {
+        if (n->left)
+            return Rightmost(n->left);
+        while (n->parent && n->parent->left == n)
+            n = n->parent;
+        return n->parent;
+    }
+
+    void Recalc(Node* n)
+    {
+        n->height = 1 + std::max(Height(n->left), Height(n->right));
+        n->weight = Weight(n->left) + m_weight(n->value) + Weight(n->right);
+    }
+
+    void Replace(Node* parent, Node* from, Node* to)
+    {
+        if (!parent)
+            m_root = to;
+        else if (parent->left == from)
+            parent->left = to;
+        else
+            parent->right = to;
+        if (to)
+            to->parent = parent;
+    }
+
+    Node* RotateLeft(Node* n)
+    {
+        Node* r = n->right;
+        Replace(n->parent, n, r);
+        n->right = r->left;
+        if (n->right)
+            n->right->parent = n;
+        r->left = n;
+        n->parent = r;
+        Recalc(n);
+        Recalc(r);
+        return r;
+    }
+
+    Node* RotateRight(Node* n)
+    {
+        Node* l = n->left;
+        Replace(n->parent, n, l);
+        n->left = l->right;
+        if (n->left)
+            n->left->parent = n;
+        l->right = n;
+        n->parent = l;
+        Recalc(n);
+        Recalc(l);
+        return l;
+    }
+
+    Node* Balance(Node* n)
+    {
+        Recalc(n);
+        int balance = Height(n->left) - Height(n->right);
+        if (balance > 1)
+        {
+            if (Height(n->left->left) < Height(n->left->right))
+                RotateLeft(n->left);
+            return RotateRight(n);
+        }
+        else if (balance < -1)
+        {
+            if (Height(n->right->right) < Height(n->right->left))
+                RotateRight(n->right);
+            return RotateLeft(n);
+        }
+        return n;
+    }
+
+    //recalc weights and restore balance from node up to root
+    void Retrace(Node* n)
+    {
+        while (n)
+            n = Balance(n)->parent;
+    }
+
+    static void Free(Node* n)
+    {
+        if (!n)
+            return;
+        Free(n->left);
+        Free(n->right);
+        delete n;
+    }
+
+public:
+    template <typename V>
+    class Iterator
+    {
+        friend class BuffTree;
+        template <typename> friend class Iterator;
+
+        const BuffTree* m_tree{};
+        Node*           m_node{};
+
+        Iterator(const BuffTree* tree, Node* node) : m_tree{tree}, m_node{node} {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = V*;
+        using reference         = V&;
+
+        Iterator() = default;
+        template <typename U>
+        Iterator(const Iterator<U>& it) : m_tree{it.m_tree}, m_node{it.m_node} {}
+
+        reference operator*() const  { return m_node->value; }
+        pointer   operator->() const { return &m_node->value; }
+
+        Iterator& operator++()   { m_node = Next(m_node); return *this; }
+        Iterator  operator++(int){ auto it{*this}; ++*this; return it; }
+        Iterator& operator--()   { m_node = m_node ? Prev(m_node) : Rightmost(m_tree->m_root); return *this; }
+        Iterator  operator--(int){ auto it{*this}; --*this; return it; }
+
+        friend bool operator==(const Iterator& it1, const Iterator& it2) { return it1.m_node == it2.m_node; }
+        friend bool operator!=(const Iterator& it1, const Iterator& it2) { return it1.m_node != it2.m_node; }
+    };
+
+    using iterator       = Iterator<T>;
+    using const_iterator = Iterator<const T>;
+
+    BuffTree() = default;
+    BuffTree(const BuffTree&) = delete;
+    void operator= (const BuffTree&) = delete;
+    ~BuffTree() { Free(m_root); }
+
+    iterator        begin()         { return {this, Leftmost(m_root)}; }
+    iterator        end()           { return {this, nullptr}; }
+    const_iterator  begin() const   { return {this, Leftmost(m_root)}; }
+    const_iterator  end() const     { return {this, nullptr}; }
+
+    bool    empty() const   { return m_size == 0; }
+    size_t  size() const    { return m_size; }
+    size_t  weight() const  { return Weight(m_root); }
+    T&      back()          { return Rightmost(m_root)->value; }
+
+    void clear()
+    {
+        Free(m_root);
+        m_root = nullptr;
+        m_size = 0;
+    }
+
+    //insert before pos
+    iterator insert(iterator pos, const T& value)
+    {
+        Node* node = new Node(value);
+        Node* next = pos.m_node;
+        Node* parent;
+
+        if (!m_root)
+            m_root = node;
+        else if (!next)
+        {
+            parent = Rightmost(m_root);
+            parent->right = node;
+            node->parent = parent;
+        }
+        else if (!next->left)
+        {
+            next->left = node;
+            node->parent = next;
+        }
+        else
+        {
+            parent = Rightmost(next->left);
+            parent->right = node;
+            node->parent = parent;
+        }
+
+        ++m_size;
+        Retrace(node);
+        return {this, node};
+    }
+
+    iterator push_back(const T& value) { return insert(end(), value); }
+
+    iterator erase(iterator pos)
+    {
+        Node* node = pos.m_node;
+        Node* next = Next(node);
+        Node* start;
+
+        if (node->left && node->right)
+        {
+            //put next node to the place of deleted one
+            if (next->parent == node)
+                start = next;
+            else
+            {
+                start = next->parent;
+                start->left = next->right;
+                if (next->right)
+                    next->right->parent = start;
+                next->right = node->right;
+                node->right->parent = next;
+            }
+            next->left = node->left;
+            node->left->parent = next;
+            Replace(node->parent, node, next);
+            next->height = node->height;
+        }
+        else
+        {
+            start = node->parent;
+            Replace(node->parent, node, node->left ? node->left : node->right);
+        }
+
+        delete node;
+        --m_size;
+        Retrace(start);
+        return {this, next};
+    }
+
+    //must be called after changing of element weight
+    void Update(iterator pos)
+    {
+        Retrace(pos.m_node);
+    }
+
+    //find element that contains position 'pos' of accumulated weight
+    //return iterator and weight of all previous elements
+    //if pos is out of range return last element
+    std::pair<iterator, size_t> Find(size_t pos)
+    {
+        Node* n = m_root;
+        size_t first{};
+        while (n)
+        {
+            size_t left = Weight(n->left);
+            if (pos < first + left)
+            {
+                n = n->left;
+                continue;
+            }
+
+            size_t w = m_weight(n->value);
+            if (pos < first + left + w)
+                return {iterator{this, n}, first + left};
+
+            first += left + w;
+            n = n->right;
+        }
+
+        Node* last = Rightmost(m_root);
+        if (!last)
+            return {end(), 0};
+        return {iterator{this, last}, Weight(m_root) - m_weight(last->value)};
+    }
+};
+
+} //namespace _Utils
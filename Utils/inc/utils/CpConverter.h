@@ -41,6 +41,8 @@ class CpConverter
     std::string m_cp;
     iconv_t     m_iconvFrom{ s_invalidIconv };
     iconv_t     m_iconvTo{ s_invalidIconv };
+    bool        m_utf8{};   //converted without iconv
+    bool        m_ascii{};  //ASCII symbols have the same codes in code page
     
     CpConverter() = delete;
     CpConverter(const CpConverter&) = delete;
@@ -53,6 +55,10 @@ public:
     bool Convert(std::string_view str, std::u16string& out);
     bool Convert(char16_t ch, std::string& out);
 
+    //built-in conversion with the same result as iconv
+    static bool Utf8ToU16(std::string_view str, std::u16string& out);
+    static bool U16ToUtf8(char16_t ch, std::string& out);
+
     static std::list<std::string> GetCpList();
 
     static std::u16string FixPrintWidth(const std::u16string& str, size_t offset, size_t width);
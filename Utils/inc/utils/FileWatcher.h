@@ -0,0 +1,96 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <filesystem>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace _Utils
+{
+
+//events collected for watched file
+enum watch_event : uint32_t
+{
+    watch_none      = 0,
+    watch_changed   = 1,//data or attributes were changed
+    watch_removed   = 2,//file was deleted or moved, watch is not valid more
+};
+
+//shared service of file changes notification (inotify)
+//events are collected by own thread and taken from the main loop
+//if notification is not available Add returns invalid id and files have to be polled
+class FileWatcher
+{
+public:
+    using watch_t = int;
+    using notify_func = std::function<void()>;
+    inline static const watch_t c_invalid{-1};
+
+private:
+    struct Watch
+    {
+        std::filesystem::path   path;
+        size_t                  refs{};
+        uint32_t                events{};
+        bool                    alive{};
+    };
+
+    int                     m_fd{-1};
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::unordered_map<watch_t, Watch> m_watches;
+    std::atomic_bool        m_stop{};
+    notify_func             m_notify;//called from watcher thread on new events
+
+    FileWatcher();
+    ~FileWatcher();
+    void    Worker();
+
+public:
+    FileWatcher(const FileWatcher&) = delete;
+    void operator= (const FileWatcher&) = delete;
+
+    static FileWatcher& getInstance()
+    {
+        static FileWatcher s_watcher;
+        return s_watcher;
+    }
+
+    bool    IsAvailable() const { return m_fd >= 0; }
+    void    SetNotify(notify_func func);
+    watch_t Add(const std::filesystem::path& path);
+    void    Remove(watch_t id);
+    //return collected events and clear them, lost watch has to be removed by owner
+    uint32_t TakeEvents(watch_t id);
+};
+
+} //namespace _Utils
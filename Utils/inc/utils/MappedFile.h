@@ -0,0 +1,68 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <cstdint>
+
+namespace _Utils
+{
+
+//read only mapping of whole file to memory,
+//pages of file truncated by other process are read as zeros instead of SIGBUS
+class MappedFile
+{
+    const char* m_data{};
+    size_t      m_size{};
+#ifdef WIN32
+    void*       m_file{};
+    void*       m_map{};
+#else
+    int         m_slot{-1};//range registered for SIGBUS handler
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    void operator= (const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool    Open(const std::filesystem::path& file);
+    void    Close();
+    bool    IsOpen() const  { return m_data != nullptr; }
+    size_t  GetSize() const { return m_size; }
+
+    //return empty view if range is out of file
+    std::string_view GetView(uint64_t offset, size_t size) const;
+    //hint for kernel to read range in background
+    void    Prefetch(uint64_t offset, size_t size) const;
+    //file was truncated while it was mapped and some data was read as zeros
+    bool    IsTruncated() const;
+};
+
+} //namespace _Utils
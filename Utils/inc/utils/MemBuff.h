@@ -26,7 +26,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #pragma once
 
+#include "utils/BuffTree.h"
+#include "utils/OffsetList.h"
+
 #include <cstdint>
+#include <algorithm>
 #include <array>
 #include <list>
 #include <memory>
@@ -34,6 +38,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <vector>
 #include <optional>
 #include <functional>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <deque>
+#include <map>
+#include <mutex>
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -43,11 +53,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
   #define STEP_BLOCKS      0x10
   #define MAXBLOCKS_NUM   0x100
 #else
-  #define BUFF_SIZE     0x10000 //64k max
+  #define BUFF_SIZE     0x10000 //64k default and min block size
   #define STEP_BLOCKS     0x100
-  #define MAXBLOCKS_NUM  0x1000
+  #define MAXBLOCKS_NUM  0x1000 //default memory limit in blocks
 #endif
 
+#define MAX_BUFF_SIZE  0x400000 //4M max block size
 #define MAX_STRLEN (BUFF_SIZE / 2)
 
 namespace _Editor
@@ -70,26 +81,236 @@ struct _hbuff
 };
 using hbuff_t = _hbuff;
 
+struct PoolStat
+{
+    size_t  allocated{};    //number of allocated blocks
+    size_t  hits{};         //block was found in pool
+    size_t  misses{};       //block was lost and must be reloaded
+    size_t  evictions{};    //block was taken from another owner
+    size_t  spills{};       //modified block was saved to swap file
+    size_t  restores{};     //modified block was loaded from swap file
+    size_t  packs{};        //block was compressed in memory
+    size_t  unpacks{};      //block was decompressed from memory
+    size_t  packedSize{};   //memory of compressed blocks
+};
+
+struct MemStat
+{
+    size_t  blocks{};       //number of blocks
+    size_t  strings{};      //number of strings
+    size_t  dataSize{};     //size of text
+    size_t  poolSize{};     //memory of blocks taken from pool
+    size_t  offsetSize{};   //memory of string offset tables
+    size_t  infoSize{};     //memory of block descriptors
+    size_t  wideBlocks{};   //blocks with 32 bit offsets
+};
+
 template <typename Tbuff>
 class BuffPool
 {
-    std::array<std::shared_ptr<Tbuff>, MAXBLOCKS_NUM> m_blockArray;
+    static constexpr uint32_t c_nil{ UINT32_MAX };
+
+    //intrusive LRU list node for every block
+    struct Link
+    {
+        uint32_t    prev{c_nil};
+        uint32_t    next{c_nil};
+        uint32_t    version{};
+        uint32_t    pins{};     //number of pointers taken from pool
+        uint32_t    size{BUFF_SIZE};//block memory size
+        bool        linked{};   //block is in pool (not pinned by pointer)
+        bool        owned{};    //block has owner
+        bool        dirty{};    //block was modified and must be saved before reuse
+    };
+
+    struct SwapEntry
+    {
+        uint64_t    offset;
+        size_t      size;
+        size_t      slot;
+    };
+
+    struct PackEntry
+    {
+        std::string data;
+        size_t      size;
+        bool        dirty;
+    };
+
+    //block tables grow on demand
+    std::vector<std::shared_ptr<Tbuff>> m_blockArray;
+    std::vector<Link>   m_links;
+    //pool is shared by all threads, every public function takes the lock
+    mutable std::mutex  m_mutex;
     //in blocksPool used blocks are in the begin and free blocks are in the end
-    std::list<hbuff_t>  m_blockPool;
+    uint32_t            m_head{c_nil};
+    uint32_t            m_tail{c_nil};
     size_t              m_usedBlocks{};
     size_t              m_stepBlocks{1};
+    //blocks have different sizes so memory is counted in bytes
+    size_t              m_ownedSize{};
+    size_t              m_allocSize{};
+    size_t              m_maxSize{MAXBLOCKS_NUM * BUFF_SIZE};
+    PoolStat            m_stat;
+
+    //swap file for modified blocks taken from pool
+    std::filesystem::path   m_swapPath; //directory
+    std::filesystem::path   m_swapName; //opened file
+    std::fstream            m_swapFile;
+    std::unordered_map<uint64_t, SwapEntry> m_swapMap;
+    std::multimap<size_t, uint64_t> m_swapFree;//slot size -> offset
+    uint64_t                m_swapEnd{};
+
+    //compressed blocks taken from pool, the oldest are dropped or swapped over limit
+    std::unordered_map<uint64_t, PackEntry> m_packMap;
+    std::deque<uint64_t>    m_packQueue;
+    size_t                  m_packSize{};
+    size_t                  m_maxPackSize{MAXBLOCKS_NUM * BUFF_SIZE};
+
+    static uint64_t SwapKey(hbuff_t hbuff) { return (static_cast<uint64_t>(hbuff.index) << 32) | hbuff.version; }
+
+    void        PushFront(uint32_t index);
+    void        PushBack(uint32_t index);
+    void        Unlink(uint32_t index);
+    bool        IsResident(hbuff_t hbuff) const
+    {
+        if (hbuff.index >= m_usedBlocks || m_links[hbuff.index].version != hbuff.version)
+            return false;
+        return m_links[hbuff.index].linked || m_links[hbuff.index].pins != 0;
+    }
+    void        Unpin(uint32_t index);
+    void        AddBlocks(size_t n);
+    void        FreeMemory(uint32_t index);
+    void        FreeBlock(uint32_t index);
+    uint32_t    GetVictim();
+    bool        SwapOut(uint32_t index);
+    bool        SwapOut(uint64_t key, const char* data, size_t size);
+    bool        OpenSwap();
+    void        FreeSwap(uint64_t key);
+    bool        Pack(uint32_t index);
+    void        TrimPack();
+    void        FreePack(uint64_t key);
+    bool        ReadStored(uint64_t key, Tbuff& buff);//data stays compressed or in swap
 
 public:
     static BuffPool     s_pool;
 
     BuffPool(size_t n = STEP_BLOCKS);
-    ~BuffPool() = default;
+    ~BuffPool();
 
-    size_t      GetBuffSize() const {return BUFF_SIZE;}
-    hbuff_t     GetFreeBuff();                            //relink buff to top of pool
+    hbuff_t     GetFreeBuff(size_t size = BUFF_SIZE);     //relink buff to top of pool
     bool        ReleaseBuff(hbuff_t hbuff);               //relink to end of pool
     std::shared_ptr<Tbuff> GetBuffPointer(hbuff_t hbuff); //get buff pointer and del from pool
-    bool        ReleaseBuffPointer(hbuff_t hbuff);        //put buff to pool
+    bool        ReleaseBuffPointer(hbuff_t hbuff, bool dirty = false);//put buff to pool
+    bool        UnpinBuff(hbuff_t hbuff);                 //put buff to pool and keep dirty flag
+    bool        RestoreBuff(hbuff_t hbuff, std::shared_ptr<Tbuff> buff);//load lost buff from memory or swap
+    std::shared_ptr<Tbuff> CopyBuff(hbuff_t hbuff);      //copy of compressed or swapped buff for reader
+
+    //memory limit for blocks, when it is reached old blocks are dropped or swapped
+    void        SetMemoryLimit(size_t size)
+    {
+        std::lock_guard lock{m_mutex};
+        m_maxSize = std::max(static_cast<size_t>(BUFF_SIZE), size);
+    }
+    size_t      GetMemoryLimit() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_maxSize;
+    }
+    void        SetSwapPath(const std::filesystem::path& path)
+    {
+        std::lock_guard lock{m_mutex};
+        m_swapPath = path;
+    }
+    //memory limit for compressed blocks, 0 - don't compress
+    void        SetPackLimit(size_t size)
+    {
+        std::lock_guard lock{m_mutex};
+        m_maxPackSize = size;
+        TrimPack();
+    }
+    size_t      GetPackLimit() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_maxPackSize;
+    }
+
+    bool        IsOwned(hbuff_t hbuff) const
+    {
+        std::lock_guard lock{m_mutex};
+        return hbuff.index < m_usedBlocks && m_links[hbuff.index].owned && m_links[hbuff.index].version == hbuff.version;
+    }
+
+    PoolStat    GetStat() const
+    {
+        std::lock_guard lock{m_mutex};
+        auto stat{m_stat};
+        stat.allocated = m_usedBlocks;
+        stat.packedSize = m_packSize;
+        return stat;
+    }
+    void        ResetStat()
+    {
+        std::lock_guard lock{m_mutex};
+        m_stat = {};
+    }
+};
+
+//pin of pool block for reading from other thread,
+//pinned block is not taken from owner but its data must not be changed while pin exists.
+//Compressed or swapped block is not returned to pool, reader gets its own copy
+template <typename Tbuff>
+class BuffPin
+{
+    BuffPool<Tbuff>*        m_pool{};
+    hbuff_t                 m_hbuff{};
+    std::shared_ptr<Tbuff>  m_buff;
+    bool                    m_copy{};
+
+public:
+    BuffPin() = default;
+    BuffPin(BuffPool<Tbuff>& pool, hbuff_t hbuff) : m_pool{&pool}, m_hbuff{hbuff}
+    {
+        if (hbuff == 0)
+            return;
+        m_buff = pool.GetBuffPointer(hbuff);
+        if (!m_buff)
+        {
+            m_buff = pool.CopyBuff(hbuff);
+            m_copy = m_buff != nullptr;
+        }
+    }
+    BuffPin(const BuffPin&) = delete;
+    void operator= (const BuffPin&) = delete;
+    BuffPin(BuffPin&& pin) noexcept : m_pool{pin.m_pool}, m_hbuff{pin.m_hbuff}, m_buff{std::move(pin.m_buff)}, m_copy{pin.m_copy} {}
+    BuffPin& operator= (BuffPin&& pin) noexcept
+    {
+        if (this != &pin)
+        {
+            Reset();
+            m_pool = pin.m_pool;
+            m_hbuff = pin.m_hbuff;
+            m_buff = std::move(pin.m_buff);
+            m_copy = pin.m_copy;
+        }
+        return *this;
+    }
+    ~BuffPin() { Reset(); }
+
+    void    Reset()
+    {
+        if (m_buff)
+        {
+            m_buff.reset();
+            if (!m_copy)
+                m_pool->UnpinBuff(m_hbuff);
+        }
+        m_copy = false;
+    }
+
+    explicit operator bool() const      { return m_buff != nullptr; }
+    const Tbuff& operator*() const      { return *m_buff; }
+    const Tbuff* operator->() const     { return m_buff.get(); }
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -102,20 +323,41 @@ class SBuff
     friend class MemStrBuff<std::string, std::string_view>;
 
 protected:
+    static constexpr uint32_t c_noGap{ UINT32_MAX };
+    static constexpr uint32_t c_gapStep{ 0x400 };
+
     //we use last element as 'end of buffer' offset
-    std::vector<uint32_t>           m_strOffsetList{};
+    //while editing buffer has gap between strings at last edit position,
+    //offsets of strings before gap are from begin of data and after gap from end of data
+    OffsetList                      m_strOffsetList{};
     bool                            m_mod{false};
     std::shared_ptr<Tbuff>          m_buff;
+    uint32_t                        m_gapStr{c_noGap};//first string after gap
+    uint32_t                        m_gapSize{};
+    uint32_t                        m_dataSize{};//size of data without gap
 
-    uint32_t GetStrOffset(size_t n) { return n == 0 ? 0 : m_strOffsetList[n - 1]; }
+    uint32_t GetStrOffset(size_t n) const
+    {
+        if (n == 0)
+            return 0;
+        return n - 1 < m_gapStr ? m_strOffsetList[n - 1] : m_dataSize - m_strOffsetList[n - 1];
+    }
+    void    MoveGap(size_t n);
+    bool    ReserveGap(uint32_t size);
 
 public:
     SBuff() = default;
     ~SBuff() = default;
 
     bool    Clear();
-    size_t  GetStrCount() { return m_strOffsetList.size(); }
-    uint32_t GetBuffSize() { return m_strOffsetList.empty() ? 0 : m_strOffsetList.back(); }
+    bool    CloseGap();//make data continuous
+    size_t  GetStrCount() const { return m_strOffsetList.size(); }
+    uint32_t GetBuffSize() const
+    {
+        if (m_gapStr != c_noGap)
+            return m_dataSize;
+        return m_strOffsetList.empty() ? 0 : m_strOffsetList.back();
+    }
 
     Tview   GetStr(size_t n);
     bool    AddStr(size_t n, const Tview str);
@@ -133,15 +375,25 @@ class StrBuff : public SBuff<Tbuff, Tview>
 
     //we save string in buffer as in file
     hbuff_t     m_buffHandle{0};
+    uint32_t    m_blockSize{BUFF_SIZE};
     uint64_t    m_fileOffset{};//offset from begin of file
     bool        m_lostData{false};
+    bool        m_shared{false};//block is used by snapshot for saving, it is copied before changing
+    Tview       m_mapView{};//not modified data in mapped file
 
 public:
-    StrBuff() = default;
+    explicit StrBuff(size_t blockSize = BUFF_SIZE) : m_blockSize{static_cast<uint32_t>(blockSize)} {}
     ~StrBuff();
 
+    Tview   GetStr(size_t n);
     std::shared_ptr<Tbuff> GetBuff();
     bool    ReleaseBuff();
+    bool    DropBuff();
+
+    //read strings from other thread: reader uses only pinned data, m_strOffsetList, gap fields and m_mapView,
+    //so owner must not edit block while it is pinned (editor marks such block m_shared and changes its copy)
+    BuffPin<Tbuff> Pin() const { return BuffPin<Tbuff>{BuffPool<Tbuff>::s_pool, m_buffHandle}; }
+    Tview   GetStr(const BuffPin<Tbuff>& pin, size_t n) const;
     bool    Clear();
     bool    ClearModifyFlag();
 };
@@ -151,16 +403,27 @@ template <typename Tbuff, typename Tview>
 class MemStrBuff
 {
     using LoadBuffFunc = std::function<bool(uint64_t offset, size_t size, std::shared_ptr<Tbuff> buff)>;
+    using MapBuffFunc = std::function<Tview(uint64_t offset, size_t size)>;
     friend class _Editor::Editor;
 
+    struct StrCount
+    {
+        size_t operator()(const std::shared_ptr<StrBuff<Tbuff, Tview>>& buff) const { return buff->GetStrCount(); }
+    };
+
 protected:
+    //blocks list with number of strings in subtrees for fast line search
+    using BuffList = BuffTree<std::shared_ptr<StrBuff<Tbuff, Tview>>, StrCount>;
+
     LoadBuffFunc    m_loadBuffFunc;
-    std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>> m_buffList;
+    MapBuffFunc     m_mapBuffFunc;
+    BuffList        m_buffList;
     size_t  m_totalStrCount{};
+    size_t  m_blockSize{BUFF_SIZE};
     bool    m_changed{};
 
-    typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator m_curBuff;
-    size_t  m_curBuffLine{};
+    //last used block
+    std::shared_ptr<StrBuff<Tbuff, Tview>> m_curBuff;
 
     bool LoadBuff(uint64_t offset, size_t size, std::shared_ptr<Tbuff> buff)
     {
@@ -169,28 +432,36 @@ protected:
         return true;
     }
 
-    std::optional<typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator> GetBuff(size_t& line);
+    std::optional<typename BuffList::iterator> GetBuff(size_t& line, bool write = false);
+    bool    Detach(typename BuffList::iterator buff);
     bool    ReleaseBuff();
-    bool    SplitBuff(typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator buff, size_t line);
-    bool    DelBuff(typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator& buff);
+    bool    SplitBuff(typename BuffList::iterator buff, size_t line);
+    bool    DelBuff(typename BuffList::iterator& buff);
 
 public:
-    MemStrBuff();
+    MemStrBuff() = default;
 
     bool    SetLoadBuffFunc(LoadBuffFunc func) { m_loadBuffFunc = func; return true; };
+    bool    SetMapBuffFunc(MapBuffFunc func) { m_mapBuffFunc = func; return true; };
+    bool    ResetMapping();
     bool    IsChanged() const { return m_changed; }
     size_t  GetSize() const;
+    //size of new blocks, big blocks are good for huge files and small ones for editing
+    void    SetBlockSize(size_t size) { m_blockSize = std::clamp(size, static_cast<size_t>(BUFF_SIZE), static_cast<size_t>(MAX_BUFF_SIZE)); }
+    size_t  GetBlockSize() const { return m_blockSize; }
 
     bool    Clear();
     bool    ClearModifyFlag();
     size_t  GetStrCount() const { return m_totalStrCount; }
+    MemStat GetMemStat() const;
     Tview   GetStr(size_t n);
     bool    AddStr(size_t n, const Tview str);
     bool    AppendStr(const Tview str) {return AddStr(m_totalStrCount, str);}
     bool    ChangeStr(size_t n, const Tview str);
     bool    DelStr(size_t n);
 
-    std::shared_ptr<StrBuff<Tbuff, Tview>> GetNewBuff();
+    //add filled block to the end of list
+    bool    AppendBuff(std::shared_ptr<StrBuff<Tbuff, Tview>> buff);
 
     //std::pair<size_t, bool> FindStr(const std::string& str);
 };
@@ -0,0 +1,125 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace _Utils
+{
+
+//list of string offsets in block
+//offsets are kept in 16 bit while they fit and are widened to 32 bit on first big value
+class OffsetList
+{
+    std::vector<uint16_t>   m_short;
+    std::vector<uint32_t>   m_long;
+    bool                    m_wide{};
+
+    void Widen()
+    {
+        m_long.assign(m_short.cbegin(), m_short.cend());
+        m_short.clear();
+        m_short.shrink_to_fit();
+        m_wide = true;
+    }
+
+public:
+    bool    IsWide() const  { return m_wide; }
+    bool    empty() const   { return m_wide ? m_long.empty() : m_short.empty(); }
+    size_t  size() const    { return m_wide ? m_long.size() : m_short.size(); }
+    uint32_t back() const   { return m_wide ? m_long.back() : m_short.back(); }
+    uint32_t operator[](size_t n) const { return m_wide ? m_long[n] : m_short[n]; }
+
+    //memory used by offsets
+    size_t  GetMemSize() const
+    {
+        return m_wide ? m_long.capacity() * sizeof(uint32_t) : m_short.capacity() * sizeof(uint16_t);
+    }
+
+    void clear()
+    {
+        m_short.clear();
+        m_long.clear();
+        m_wide = false;
+    }
+
+    void shrink_to_fit()
+    {
+        m_short.shrink_to_fit();
+        m_long.shrink_to_fit();
+    }
+
+    void Set(size_t n, uint32_t offset)
+    {
+        if (!m_wide && offset > UINT16_MAX)
+            Widen();
+        if (m_wide)
+            m_long[n] = offset;
+        else
+            m_short[n] = static_cast<uint16_t>(offset);
+    }
+
+    void push_back(uint32_t offset)
+    {
+        if (!m_wide && offset > UINT16_MAX)
+            Widen();
+        if (m_wide)
+            m_long.push_back(offset);
+        else
+            m_short.push_back(static_cast<uint16_t>(offset));
+    }
+
+    void insert(size_t n, uint32_t offset)
+    {
+        if (!m_wide && offset > UINT16_MAX)
+            Widen();
+        if (m_wide)
+            m_long.insert(m_long.begin() + n, offset);
+        else
+            m_short.insert(m_short.begin() + n, static_cast<uint16_t>(offset));
+    }
+
+    void erase(size_t n)
+    {
+        if (m_wide)
+            m_long.erase(m_long.begin() + n);
+        else
+            m_short.erase(m_short.begin() + n);
+    }
+
+    void resize(size_t n)
+    {
+        if (m_wide)
+            m_long.resize(n);
+        else
+            m_short.resize(n);
+    }
+};
+
+} //namespace _Utils
@@ -0,0 +1,130 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "utils/MemBuff.h"
+#include "utils/BuffTree.h"
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace _Utils
+{
+
+/////////////////////////////////////////////////////////////////////////////
+//end offsets of strings, they are kept as 32 bit offsets from the begin of block of strings
+class StrIndex
+{
+    std::vector<uint64_t>   m_block;    //offsets of blocks
+    std::vector<uint32_t>   m_strEnd;   //end offsets of strings in block
+
+public:
+    static constexpr size_t c_blockStr{ 0x400 };
+
+    bool    Append(uint64_t end);
+    bool    DelLast();
+    void    Clear() { m_block.clear(); m_strEnd.clear(); }
+    size_t  GetCount() const { return m_strEnd.size(); }
+    uint64_t GetEnd(size_t n) const { return m_block[n / c_blockStr] + m_strEnd[n]; }
+    uint64_t GetBegin(size_t n) const { return n % c_blockStr ? GetEnd(n - 1) : m_block[n / c_blockStr]; }
+    uint64_t GetSize() const { return m_strEnd.empty() ? 0 : GetEnd(m_strEnd.size() - 1); }
+    size_t  GetMemSize() const { return m_block.capacity() * sizeof(uint64_t) + m_strEnd.capacity() * sizeof(uint32_t); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+//strings storage as list of pieces of original data (mapped file) and append only added data
+//it has the same interface as MemStrBuff,
+//original data is not copied and edits change only pieces
+template <typename Tbuff, typename Tview>
+class PieceTable
+{
+    struct Piece
+    {
+        bool    add{};      //piece from added strings
+        size_t  first{};    //first string in source
+        size_t  count{};    //number of strings
+    };
+
+    struct StrCount
+    {
+        size_t operator()(const Piece& piece) const { return piece.count; }
+    };
+
+    using PieceList = BuffTree<Piece, StrCount>;
+
+    static constexpr size_t c_addBuffSize{ BUFF_SIZE };
+
+    Tview                   m_orig;     //original data
+    StrIndex                m_origStr;  //end offsets of original strings
+    std::deque<Tbuff>       m_addBuff;  //added data, buffers are never reallocated
+    std::vector<Tview>      m_addStr;   //added strings
+    uint64_t                m_addSize{};//size of added strings
+    uint64_t                m_addFree{};//size of added strings which are not used
+    PieceList               m_pieceList;
+
+    uint64_t    m_size{};
+    bool        m_changed{};
+
+    Tview   GetSourceStr(const Piece& piece, size_t n) const;
+    size_t  AddSourceStr(const Tview str);
+    void    InsertPiece(size_t n, const Piece& piece);
+    bool    Compact();
+
+public:
+    PieceTable() = default;
+    PieceTable(const PieceTable&) = delete;
+    void operator= (const PieceTable&) = delete;
+
+    //original data is set before loading of string offsets
+    bool    SetOriginal(const Tview data) { m_orig = data; return true; }
+    bool    AppendOriginalStr(uint64_t end);
+    //the last not finished original string is removed before loading of tail,
+    //it fails if the string was changed
+    bool    DelLastOriginalStr();
+    uint64_t GetOriginalSize() const { return m_origStr.GetSize(); }
+    //take data with new string offsets after saving
+    bool    Rebase(const Tview data, StrIndex&& strEnd);
+    //call func for continuous data parts in order
+    bool    ForEachPart(const std::function<bool(const Tview)>& func) const;
+
+    bool    IsChanged() const { return m_changed; }
+    uint64_t GetSize() const { return m_size; }
+    size_t  GetPieceCount() const { return m_pieceList.size(); }
+
+    bool    Clear();
+    bool    ClearModifyFlag() { m_changed = false; return true; }
+    size_t  GetStrCount() const { return m_pieceList.weight(); }
+    MemStat GetMemStat() const;
+    Tview   GetStr(size_t n);
+    bool    AddStr(size_t n, const Tview str);
+    bool    AppendStr(const Tview str) { return AddStr(GetStrCount(), str); }
+    bool    ChangeStr(size_t n, const Tview str);
+    bool    DelStr(size_t n);
+};
+
+} //namespace _Utils
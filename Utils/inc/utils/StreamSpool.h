@@ -0,0 +1,74 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace _Utils
+{
+
+//copying of non-seekable stream (pipe, stdin) to spool file in background
+//spool file is used as regular file growing while data arrives
+class StreamSpool
+{
+    inline static const size_t c_chunkSize{ 0x10000 };
+
+    int                     m_fd{-1};
+    int                     m_file{-1};//spool file is written by descriptor, it can't be replaced by other file
+    std::filesystem::path   m_path;
+    std::thread             m_thread;
+    std::atomic<uint64_t>   m_size{};
+    std::atomic_bool        m_eof{};
+    std::atomic_bool        m_stop{};
+
+    void    Pump();
+    bool    Create(const std::filesystem::path& dir, const std::string& name);
+    bool    Write(const char* data, size_t size);
+
+public:
+    StreamSpool() = default;
+    StreamSpool(const StreamSpool&) = delete;
+    void operator= (const StreamSpool&) = delete;
+    ~StreamSpool() { Close(); }
+
+    //spool file is created with unique name <dir>/<name>-<pid>-XXXXXX.txt
+    bool    Open(int fd, const std::filesystem::path& dir, const std::string& name);
+    void    Close(bool remove = true);
+    //waits for the first data or EOF no more than timeout
+    bool    WaitData(uint32_t timeoutMs);
+
+    bool    IsOpen() const { return m_fd >= 0; }
+    bool    IsEof() const { return m_eof; }
+    uint64_t GetSize() const { return m_size; }
+    const std::filesystem::path& GetPath() const { return m_path; }
+};
+
+} //namespace _Utils
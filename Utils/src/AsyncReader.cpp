@@ -0,0 +1,220 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/AsyncReader.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <cerrno>
+#endif
+
+namespace _Utils
+{
+
+bool AsyncReader::Open(const std::filesystem::path& file, bool sequential)
+{
+    Close();
+
+#ifdef WIN32
+    HANDLE hFile = CreateFileW(file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size))
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_file = hFile;
+    m_size = static_cast<uint64_t>(size.QuadPart);
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, sequential ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_NORMAL);
+#endif
+    m_file = fd;
+    m_size = static_cast<uint64_t>(st.st_size);
+#endif
+
+    m_stop = false;
+    return true;
+}
+
+void AsyncReader::Close()
+{
+    {
+        std::lock_guard lock{ m_mutex };
+        m_stop = true;
+    }
+    m_queueCond.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    m_queue.clear();
+
+    if (!IsOpen())
+        return;
+#ifdef WIN32
+    CloseHandle(m_file);
+    m_file = nullptr;
+#else
+    close(m_file);
+    m_file = -1;
+#endif
+    m_size = 0;
+}
+
+size_t AsyncReader::Read(uint64_t offset, size_t size, char* buff) const
+{
+    if (!IsOpen() || offset >= m_size)
+        return 0;
+
+    size_t read{};
+    while (read < size)
+    {
+#ifdef WIN32
+        //positioned read on synchronous handle doesn't use file pointer
+        OVERLAPPED ov{};
+        uint64_t pos{ offset + read };
+        ov.Offset = static_cast<DWORD>(pos);
+        ov.OffsetHigh = static_cast<DWORD>(pos >> 32);
+        DWORD part{};
+        DWORD toRead{ static_cast<DWORD>(std::min(size - read, static_cast<size_t>(0x40000000))) };
+        if (!ReadFile(m_file, buff + read, toRead, &part, &ov) || part == 0)
+            break;
+#else
+        auto part = pread(m_file, buff + read, size - read, static_cast<off_t>(offset + read));
+        if (part < 0 && errno == EINTR)
+            continue;
+        if (part <= 0)
+            break;
+#endif
+        read += static_cast<size_t>(part);
+    }
+
+    return read;
+}
+
+void AsyncReader::Prefetch([[maybe_unused]] uint64_t offset, [[maybe_unused]] size_t size) const
+{
+#if !defined(WIN32) && defined(POSIX_FADV_WILLNEED)
+    if (IsOpen() && offset < m_size)
+        posix_fadvise(m_file, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+}
+
+bool AsyncReader::Queue(uint64_t offset, size_t size)
+{
+    if (!IsOpen())
+        return false;
+
+    auto request = std::make_shared<Request>();
+    request->offset = offset;
+    request->size = size;
+    request->buff = std::make_shared<std::string>();
+    Prefetch(offset, size);
+
+    {
+        std::lock_guard lock{ m_mutex };
+        m_queue.push_back(request);
+        //workers are started with the first request
+        if (m_workers.size() < m_threads && m_workers.size() < m_queue.size())
+            m_workers.emplace_back(&AsyncReader::Worker, this);
+    }
+    m_queueCond.notify_one();
+    return true;
+}
+
+size_t AsyncReader::Wait(std::shared_ptr<std::string>& buff)
+{
+    std::unique_lock lock{ m_mutex };
+    if (m_queue.empty())
+        return 0;
+
+    auto request = m_queue.front();
+    m_doneCond.wait(lock, [&request] { return request->done; });
+    m_queue.pop_front();
+
+    buff = request->buff;
+    return buff->size();
+}
+
+void AsyncReader::Worker()
+{
+    for (;;)
+    {
+        std::shared_ptr<Request> request;
+        {
+            std::unique_lock lock{ m_mutex };
+            m_queueCond.wait(lock, [this, &request] {
+                if (m_stop)
+                    return true;
+                for (auto& r : m_queue)
+                    if (!r->started)
+                    {
+                        request = r;
+                        return true;
+                    }
+                return false;
+            });
+            if (m_stop)
+                return;
+            request->started = true;
+        }
+
+        request->buff->resize(request->size);
+        size_t read = Read(request->offset, request->size, request->buff->data());
+        request->buff->resize(read);
+
+        {
+            std::lock_guard lock{ m_mutex };
+            request->done = true;
+        }
+        m_doneCond.notify_all();
+    }
+}
+
+} //namespace _Utils
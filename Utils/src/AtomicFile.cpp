@@ -0,0 +1,386 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/AtomicFile.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+#include <vector>
+#include <ctime>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <cerrno>
+    #if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+        #define USE_COPY_FILE_RANGE
+    #endif
+#endif
+
+namespace _Utils
+{
+
+bool AtomicFile::Open(const std::filesystem::path& path)
+{
+    Discard();
+
+    m_path = path;
+    m_tmpPath.clear();
+    m_size = 0;
+
+#ifdef WIN32
+    //original file can be absent, then only Write is possible
+    HANDLE hSrc = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    BY_HANDLE_FILE_INFORMATION info{};
+    if (hSrc != INVALID_HANDLE_VALUE && GetFileInformationByHandle(hSrc, &info) && info.nNumberOfLinks > 1)
+    {
+        LOG(INFO) << __FUNC__ << " file has hard links, path=" << path.u8string();
+        CloseHandle(hSrc);
+        return false;
+    }
+
+    //temporary file name is unique in directory, existing file is never reused
+    HANDLE hDst{ INVALID_HANDLE_VALUE };
+    for (unsigned n = 0; n < c_tmpTries && hDst == INVALID_HANDLE_VALUE; ++n)
+    {
+        m_tmpPath = GetTmpName(GetCurrentProcessId() + n * 7919 + GetTickCount());
+        hDst = CreateFileW(m_tmpPath.wstring().c_str(), GENERIC_WRITE, 0,
+            NULL, CREATE_NEW, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hDst == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS)
+            break;
+    }
+    if (hDst == INVALID_HANDLE_VALUE)
+    {
+        LOG(INFO) << __FUNC__ << " create error=" << GetLastError() << " path=" << m_tmpPath.u8string();
+        if (hSrc != INVALID_HANDLE_VALUE)
+            CloseHandle(hSrc);
+        m_tmpPath.clear();
+        return false;
+    }
+
+    m_src = hSrc != INVALID_HANDLE_VALUE ? hSrc : nullptr;
+    m_dst = hDst;
+
+    std::error_code ec;
+    std::filesystem::permissions(m_tmpPath, std::filesystem::status(path, ec).permissions(), ec);
+#else
+    //renaming replaces link itself, so such file can be overwritten only
+    struct stat lst{};
+    if (lstat(path.c_str(), &lst) == 0 && (S_ISLNK(lst.st_mode) || lst.st_nlink > 1))
+    {
+        LOG(INFO) << __FUNC__ << " file is link, path=" << path.u8string();
+        return false;
+    }
+
+    int src = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st{};
+    if (src >= 0 && fstat(src, &st) != 0)
+    {
+        close(src);
+        src = -1;
+    }
+
+    //temporary file name is unique in directory, O_EXCL doesn't follow symlinks and doesn't reuse existing file
+    int dst{ -1 };
+    for (unsigned n = 0; n < c_tmpTries && dst < 0; ++n)
+    {
+        m_tmpPath = GetTmpName(static_cast<unsigned>(getpid()) + n * 7919 + static_cast<unsigned>(time(nullptr)));
+        dst = open(m_tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+        if (dst < 0 && errno != EEXIST)
+            break;
+    }
+    if (dst < 0)
+    {
+        LOG(INFO) << __FUNC__ << " create error=" << errno << " path=" << m_tmpPath.u8string();
+        if (src >= 0)
+            close(src);
+        m_tmpPath.clear();
+        return false;
+    }
+
+    if (src >= 0)
+    {
+        //new file keeps owner and mode of original one, else original file is overwritten
+        if ((st.st_uid != geteuid() || st.st_gid != getegid()) && fchown(dst, st.st_uid, st.st_gid) != 0)
+        {
+            LOG(INFO) << __FUNC__ << " owner can't be kept error=" << errno << " path=" << path.u8string();
+            close(src);
+            close(dst);
+            unlink(m_tmpPath.c_str());
+            m_tmpPath.clear();
+            return false;
+        }
+        fchmod(dst, st.st_mode & 07777);
+    #ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(src, 0, 0, POSIX_FADV_SEQUENTIAL);
+    #endif
+    }
+    else
+        fchmod(dst, 0644);
+
+    m_src = src;
+    m_dst = dst;
+#endif
+
+    return true;
+}
+
+std::filesystem::path AtomicFile::GetTmpName(unsigned seed) const
+{
+    //hidden file near original one, so rename doesn't cross file systems
+    static const char c_chars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::string suffix(6, 'a');
+    for (auto& c : suffix)
+    {
+        seed = seed * 1103515245 + 12345;
+        c = c_chars[(seed >> 16) % (sizeof(c_chars) - 1)];
+    }
+
+    auto name{ m_path.filename() };
+    auto tmpPath{ m_path };
+    tmpPath.replace_filename("." + name.u8string() + "." + suffix + ".tmp");
+    return tmpPath;
+}
+
+bool AtomicFile::Write(const char* data, size_t size)
+{
+    if (!IsOpen())
+        return false;
+
+    size_t written{};
+    while (written < size)
+    {
+#ifdef WIN32
+        DWORD part{};
+        DWORD toWrite{ static_cast<DWORD>(std::min(size - written, static_cast<size_t>(0x40000000))) };
+        if (!WriteFile(m_dst, data + written, toWrite, &part, NULL) || part == 0)
+        {
+            LOG(ERROR) << __FUNC__ << " write error=" << GetLastError();
+            return false;
+        }
+#else
+        auto part = write(m_dst, data + written, size - written);
+        if (part < 0 && errno == EINTR)
+            continue;
+        if (part <= 0)
+        {
+            LOG(ERROR) << __FUNC__ << " write error=" << errno;
+            return false;
+        }
+#endif
+        written += static_cast<size_t>(part);
+    }
+
+    m_size += size;
+    return true;
+}
+
+bool AtomicFile::Copy(uint64_t offset, uint64_t size)
+{
+#ifdef WIN32
+    if (!IsOpen() || !m_src)
+        return false;
+#else
+    if (!IsOpen() || m_src < 0)
+        return false;
+#endif
+
+#ifdef USE_COPY_FILE_RANGE
+    //file system can copy range without transfer to user space or share extents (reflink)
+    loff_t in{ static_cast<loff_t>(offset) };
+    while (size)
+    {
+        auto part = copy_file_range(m_src, &in, m_dst, nullptr, static_cast<size_t>(std::min<uint64_t>(size, 0x40000000)), 0);
+        if (part < 0 && errno == EINTR)
+            continue;
+        if (part < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+        {
+            LOG(DEBUG) << __FUNC__ << " copy_file_range error=" << errno << ", use read";
+            break;
+        }
+        if (part == 0)
+        {
+            LOG(ERROR) << __FUNC__ << " source ended at offset=" << in << " rest=" << size;
+            return false;
+        }
+        if (part < 0)
+        {
+            LOG(ERROR) << __FUNC__ << " copy error=" << errno << " offset=" << in;
+            return false;
+        }
+
+        size -= static_cast<uint64_t>(part);
+        m_size += static_cast<uint64_t>(part);
+    }
+    offset = static_cast<uint64_t>(in);
+#endif
+
+    return !size || CopyByRead(offset, size);
+}
+
+bool AtomicFile::CopyByRead(uint64_t offset, uint64_t size)
+{
+    std::vector<char> buff(static_cast<size_t>(std::min<uint64_t>(size, c_copySize)));
+    while (size)
+    {
+        size_t toRead{ static_cast<size_t>(std::min<uint64_t>(size, buff.size())) };
+#ifdef WIN32
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD part{};
+        if (!ReadFile(m_src, buff.data(), static_cast<DWORD>(toRead), &part, &ov))
+        {
+            LOG(ERROR) << __FUNC__ << " read error=" << GetLastError() << " offset=" << offset;
+            return false;
+        }
+#else
+        auto part = pread(m_src, buff.data(), toRead, static_cast<off_t>(offset));
+        if (part < 0 && errno == EINTR)
+            continue;
+        if (part < 0)
+        {
+            LOG(ERROR) << __FUNC__ << " read error=" << errno << " offset=" << offset;
+            return false;
+        }
+#endif
+        if (part == 0)
+        {
+            LOG(ERROR) << __FUNC__ << " source ended at offset=" << offset << " rest=" << size;
+            return false;
+        }
+        if (!Write(buff.data(), static_cast<size_t>(part)))
+            return false;
+        offset += static_cast<uint64_t>(part);
+        size -= static_cast<uint64_t>(part);
+    }
+
+    return true;
+}
+
+bool AtomicFile::Sync()
+{
+    if (!IsOpen())
+        return false;
+
+#ifdef WIN32
+    bool rc = FlushFileBuffers(m_dst) != 0;
+#else
+    bool rc = fsync(m_dst) == 0;
+#endif
+    if (!rc)
+        LOG(ERROR) << __FUNC__ << " sync error path=" << m_tmpPath.u8string();
+    return rc;
+}
+
+bool AtomicFile::Commit()
+{
+    if (!IsOpen())
+        return false;
+
+    //data must be on disk before rename, else crash can leave empty file under original name
+    bool rc = Sync();
+#ifdef WIN32
+    CloseHandle(m_dst);
+    m_dst = nullptr;
+    if (m_src)
+    {
+        CloseHandle(m_src);
+        m_src = nullptr;
+    }
+#else
+    rc = close(m_dst) == 0 && rc;
+    m_dst = -1;
+    if (m_src >= 0)
+    {
+        close(m_src);
+        m_src = -1;
+    }
+#endif
+
+    std::error_code ec;
+    if (!rc)
+    {
+        LOG(ERROR) << __FUNC__ << " close error path=" << m_tmpPath.u8string();
+        std::filesystem::remove(m_tmpPath, ec);
+        return false;
+    }
+
+    std::filesystem::rename(m_tmpPath, m_path, ec);
+    if (ec)
+    {
+        LOG(ERROR) << __FUNC__ << " rename error=" << ec.message() << " path=" << m_path.u8string();
+        std::filesystem::remove(m_tmpPath, ec);
+        return false;
+    }
+
+#ifndef WIN32
+    //new directory entry must be on disk too
+    auto dir{ m_path.parent_path() };
+    int dirFd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+#endif
+
+    LOG(DEBUG) << __FUNC__ << " path=" << m_path.u8string() << " size=" << m_size;
+    return true;
+}
+
+void AtomicFile::Discard()
+{
+    if (!IsOpen())
+        return;
+
+#ifdef WIN32
+    CloseHandle(m_dst);
+    m_dst = nullptr;
+    if (m_src)
+    {
+        CloseHandle(m_src);
+        m_src = nullptr;
+    }
+#else
+    close(m_dst);
+    m_dst = -1;
+    if (m_src >= 0)
+    {
+        close(m_src);
+        m_src = -1;
+    }
+#endif
+
+    std::error_code ec;
+    std::filesystem::remove(m_tmpPath, ec);
+}
+
+} //namespace _Utils
@@ -27,8 +27,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils/CpConverter.h"
 #include "utils/IntervalMap.h"
 #include "utils/logger.h"
+#include "utils/StrScan.h"
 #include "widecharwidth/widechar_width.h"
 
+#include <algorithm>
+#include <cctype>
 #include <errno.h>
 
 namespace iconvpp
@@ -56,6 +59,13 @@ CpConverter::CpConverter(const std::string& cp)
         else
             throw std::runtime_error{ "error init conversion to " + m_cp + " errno=" + std::to_string(errno) };
     }
+
+    //iconv is used only for legacy code pages, all of them from list are ASCII compatible
+    auto name{ m_cp };
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    auto cpList{ GetCpList() };
+    m_utf8 = name == "UTF-8" || name == "UTF8";
+    m_ascii = std::find(cpList.cbegin(), cpList.cend(), name) != cpList.cend();
 }
     
 CpConverter::~CpConverter()
@@ -71,17 +81,28 @@ bool CpConverter::Convert(std::string_view str, std::u16string& out)
     out.clear();
     if (m_iconvFrom == s_invalidIconv)
         return false;
+    if (m_utf8)
+        return Utf8ToU16(str, out);
+
+    //ASCII prefix of string is copied without iconv
+    size_t ascii{};
+    if (m_ascii)
+    {
+        out.resize(str.size());
+        ascii = _Utils::StrScan::WidenAscii(str.data(), str.size(), out.data());
+        if (ascii == str.size())
+            return true;
+    }
 
-    auto srcPtr = str.data();
-    size_t srcSize = str.size();
+    auto srcPtr = str.data() + ascii;
+    size_t srcSize = str.size() - ascii;
 
-    out.resize(srcSize * 2);//2x reserve
-    auto outPtr = out.data();
-    size_t outSize = out.size();
-    size_t reserv = outSize;
+    out.resize(ascii + srcSize * 2);//2x reserve
+    auto outPtr = out.data() + ascii;
+    size_t reserv = out.size();
 
     char* dstPtr = reinterpret_cast<char*>(outPtr);
-    size_t dstSize = outSize * 2;
+    size_t dstSize = srcSize * 2 * sizeof(char16_t);
 
     bool rc{ true };
     while (srcSize)
@@ -115,6 +136,14 @@ bool CpConverter::Convert(char16_t ch, std::string& out)
 {
     if (m_iconvFrom == s_invalidIconv)
         return false;
+    if (m_utf8)
+    {
+        if (U16ToUtf8(ch, out))
+            return true;
+        _assert(0);
+        out = ' ';
+        return false;
+    }
 
     const char* srcPtr = reinterpret_cast<const char*>(&ch);
     size_t srcSize = sizeof(ch);
@@ -137,6 +166,129 @@ bool CpConverter::Convert(char16_t ch, std::string& out)
     return true;
 }
 
+bool CpConverter::Utf8ToU16(std::string_view str, std::u16string& out)
+{
+    //UTF-16 string is never longer than UTF-8 one
+    out.resize(str.size());
+    auto src = reinterpret_cast<const unsigned char*>(str.data());
+    size_t size{ str.size() };
+    char16_t* dst = out.data();
+    size_t i{};
+    size_t n{};
+    bool rc{ true };
+
+    while (i < size)
+    {
+        unsigned char c = src[i];
+        if (c < 0x80)
+        {
+            //runs of ASCII symbols are widened by blocks
+            if (i + 1 < size && src[i + 1] < 0x80)
+            {
+                auto len = _Utils::StrScan::WidenAscii(str.data() + i, size - i, dst + n);
+                i += len;
+                n += len;
+            }
+            else
+            {
+                dst[n++] = c;
+                ++i;
+            }
+            continue;
+        }
+
+        //overlong forms, surrogates and symbols after U+10FFFF are invalid like in iconv
+        size_t len{};
+        uint32_t code{};
+        unsigned char lo{ 0x80 };
+        unsigned char hi{ 0xbf };
+        if (c >= 0xc2 && c <= 0xdf)
+        {
+            len = 2;
+            code = c & 0x1f;
+        }
+        else if (c >= 0xe0 && c <= 0xef)
+        {
+            len = 3;
+            code = c & 0x0f;
+            if (c == 0xe0)
+                lo = 0xa0;
+            else if (c == 0xed)
+                hi = 0x9f;
+        }
+        else if (c >= 0xf0 && c <= 0xf4)
+        {
+            len = 4;
+            code = c & 0x07;
+            if (c == 0xf0)
+                lo = 0x90;
+            else if (c == 0xf4)
+                hi = 0x8f;
+        }
+
+        size_t k{ 1 };
+        for (; k < len && i + k < size; ++k)
+        {
+            unsigned char next = src[i + k];
+            if (next < (k == 1 ? lo : 0x80) || next > (k == 1 ? hi : 0xbf))
+                break;
+            code = (code << 6) | (next & 0x3f);
+        }
+
+        if (len && k == len)
+        {
+            if (code >= 0x10000)
+            {
+                code -= 0x10000;
+                dst[n++] = static_cast<char16_t>(0xd800 + (code >> 10));
+                dst[n++] = static_cast<char16_t>(0xdc00 + (code & 0x3ff));
+            }
+            else
+                dst[n++] = static_cast<char16_t>(code);
+            i += len;
+        }
+        else if (len && i + k == size)
+        {
+            //incomplete symbol at the end
+            rc = false;
+            break;
+        }
+        else
+        {
+            //skip symbol
+            rc = false;
+            dst[n++] = '?';
+            ++i;
+        }
+    }
+
+    out.resize(n);
+    return rc;
+}
+
+bool CpConverter::U16ToUtf8(char16_t ch, std::string& out)
+{
+    if (ch < 0x80)
+        out.assign(1, static_cast<char>(ch));
+    else if (ch < 0x800)
+    {
+        out.resize(2);
+        out[0] = static_cast<char>(0xc0 | (ch >> 6));
+        out[1] = static_cast<char>(0x80 | (ch & 0x3f));
+    }
+    else if (ch >= 0xd800 && ch <= 0xdfff)
+        //surrogate can't be converted without pair
+        return false;
+    else
+    {
+        out.resize(3);
+        out[0] = static_cast<char>(0xe0 | (ch >> 12));
+        out[1] = static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+        out[2] = static_cast<char>(0x80 | (ch & 0x3f));
+    }
+    return true;
+}
+
 std::list<std::string> CpConverter::GetCpList()
 {
     return {
@@ -0,0 +1,177 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/FileWatcher.h"
+#include "utils/logger.h"
+
+#if defined(__linux__)
+    #include <sys/inotify.h>
+    #include <unistd.h>
+    #include <poll.h>
+    #include <cerrno>
+    #define USE_INOTIFY
+#endif
+
+namespace _Utils
+{
+
+#ifdef USE_INOTIFY
+constexpr uint32_t c_watchMask{ IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF };
+#endif
+
+FileWatcher::FileWatcher()
+{
+#ifdef USE_INOTIFY
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0)
+        LOG(ERROR) << __FUNC__ << " inotify error=" << errno;
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+    m_stop = true;
+    if (m_thread.joinable())
+        m_thread.join();
+#ifdef USE_INOTIFY
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+}
+
+FileWatcher::watch_t FileWatcher::Add([[maybe_unused]] const std::filesystem::path& path)
+{
+#ifdef USE_INOTIFY
+    if (m_fd < 0)
+        return c_invalid;
+
+    std::scoped_lock lock{ m_mutex };
+    watch_t id = inotify_add_watch(m_fd, path.c_str(), c_watchMask);
+    if (id < 0)
+    {
+        LOG(DEBUG) << __FUNC__ << " path=" << path.u8string() << " error=" << errno;
+        return c_invalid;
+    }
+
+    //the same file has the same id
+    auto& watch = m_watches[id];
+    if (!watch.refs)
+        watch = { path, 0, watch_none, true };
+    ++watch.refs;
+
+    if (!m_thread.joinable())
+        m_thread = std::thread([this]() { Worker(); });
+
+    //LOG(DEBUG) << __FUNC__ << " id=" << id << " path=" << path.u8string();
+    return id;
+#else
+    return c_invalid;
+#endif
+}
+
+void FileWatcher::SetNotify(notify_func func)
+{
+    std::scoped_lock lock{ m_mutex };
+    m_notify = func;
+}
+
+void FileWatcher::Remove(watch_t id)
+{
+    std::scoped_lock lock{ m_mutex };
+    auto it = m_watches.find(id);
+    if (it == m_watches.end())
+        return;
+
+    if (--it->second.refs == 0)
+    {
+#ifdef USE_INOTIFY
+        if (it->second.alive)
+            inotify_rm_watch(m_fd, id);
+#endif
+        m_watches.erase(it);
+    }
+}
+
+uint32_t FileWatcher::TakeEvents(watch_t id)
+{
+    std::scoped_lock lock{ m_mutex };
+    auto it = m_watches.find(id);
+    if (it == m_watches.end())
+        return watch_removed;
+
+    auto events = it->second.events;
+    it->second.events = watch_none;
+    if (!it->second.alive)
+        events |= watch_removed;
+    return events;
+}
+
+void FileWatcher::Worker()
+{
+#ifdef USE_INOTIFY
+    alignas(inotify_event) char buff[0x1000];
+    while (!m_stop)
+    {
+        //check for stop while there are no events
+        pollfd pfd{ m_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0)
+            continue;
+
+        auto len = read(m_fd, buff, sizeof(buff));
+        if (len <= 0)
+            continue;
+
+        std::scoped_lock lock{ m_mutex };
+        bool notify{};
+        for (char* ptr = buff; ptr < buff + len;)
+        {
+            auto event = reinterpret_cast<inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            auto it = m_watches.find(event->wd);
+            if (it == m_watches.end())
+                continue;
+
+            notify = true;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                //watch is lost with file inode
+                it->second.events |= watch_removed;
+                if (it->second.alive && !(event->mask & IN_IGNORED))
+                    inotify_rm_watch(m_fd, event->wd);
+                it->second.alive = false;
+            }
+            else
+                it->second.events |= watch_changed;
+        }
+
+        if (notify && m_notify)
+            m_notify();
+    }
+#endif
+}
+
+} //namespace _Utils
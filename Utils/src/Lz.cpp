@@ -0,0 +1,186 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/Lz.h"
+
+#include <cstring>
+#include <algorithm>
+
+//format of compressed block is a list of sequences:
+//token (literals length:4, match length-4:4), [literals length ext], literals, match offset:16, [match length ext]
+//the last sequence has literals only
+
+namespace _Utils
+{
+
+static constexpr size_t c_minMatch{ 4 };
+static constexpr size_t c_lastLiterals{ 5 };
+static constexpr size_t c_maxOffset{ 0xffff };
+static constexpr int    c_hashBits{ 12 };
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t Hash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - c_hashBits);
+}
+
+static inline void PutLength(std::string& out, size_t len)
+{
+    for (; len >= 0xff; len -= 0xff)
+        out.push_back(static_cast<char>(0xff));
+    out.push_back(static_cast<char>(len));
+}
+
+static inline bool GetLength(const uint8_t*& ip, const uint8_t* iend, size_t& len)
+{
+    uint8_t c;
+    do
+    {
+        if (ip == iend)
+            return false;
+        c = *ip++;
+        len += c;
+    } while (c == 0xff);
+    return true;
+}
+
+static void PutSequence(std::string& out, const uint8_t* lit, size_t litLen, size_t offset, size_t matchLen)
+{
+    size_t ml = matchLen ? matchLen - c_minMatch : 0;
+    auto token = static_cast<uint8_t>((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(ml, 15));
+    out.push_back(static_cast<char>(token));
+    if (litLen >= 15)
+        PutLength(out, litLen - 15);
+    out.append(reinterpret_cast<const char*>(lit), litLen);
+
+    if (matchLen)
+    {
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (ml >= 15)
+            PutLength(out, ml - 15);
+    }
+}
+
+bool Lz::Compress(const char* src, size_t size, std::string& out)
+{
+    out.clear();
+    if (size < c_minMatch + c_lastLiterals)
+        return false;
+    out.reserve(size);
+
+    uint32_t table[1 << c_hashBits]{};
+    auto data = reinterpret_cast<const uint8_t*>(src);
+    size_t limit = size - c_lastLiterals;
+    size_t anchor{};
+    size_t pos{};
+
+    while (pos + c_minMatch <= limit)
+    {
+        uint32_t seq = Read32(data + pos);
+        auto& entry = table[Hash(seq)];
+        size_t cand = entry;
+        entry = static_cast<uint32_t>(pos);
+
+        if (cand < pos && pos - cand <= c_maxOffset && Read32(data + cand) == seq)
+        {
+            size_t len = c_minMatch;
+            while (pos + len < limit && data[cand + len] == data[pos + len])
+                ++len;
+
+            PutSequence(out, data + anchor, pos - anchor, pos - cand, len);
+            if (out.size() >= size)
+                return false;
+
+            pos += len;
+            anchor = pos;
+            if (pos + c_minMatch <= limit)
+                table[Hash(Read32(data + pos - 2))] = static_cast<uint32_t>(pos - 2);
+        }
+        else
+            //skip faster over data without matches
+            pos += 1 + ((pos - anchor) >> 6);
+    }
+
+    PutSequence(out, data + anchor, size - anchor, 0, 0);
+    return out.size() < size;
+}
+
+bool Lz::Decompress(const char* src, size_t size, char* dst, size_t dstSize)
+{
+    auto ip = reinterpret_cast<const uint8_t*>(src);
+    auto iend = ip + size;
+    char* op = dst;
+    char* oend = dst + dstSize;
+
+    while (ip < iend)
+    {
+        uint8_t token = *ip++;
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !GetLength(ip, iend, litLen))
+            return false;
+        if (litLen > static_cast<size_t>(iend - ip) || litLen > static_cast<size_t>(oend - op))
+            return false;
+
+        std::memcpy(op, ip, litLen);
+        op += litLen;
+        ip += litLen;
+        if (ip == iend)
+            //the last sequence
+            break;
+
+        if (iend - ip < 2)
+            return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+
+        size_t matchLen = token & 0xf;
+        if (matchLen == 15 && !GetLength(ip, iend, matchLen))
+            return false;
+        matchLen += c_minMatch;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst) || matchLen > static_cast<size_t>(oend - op))
+            return false;
+
+        const char* match = op - offset;
+        if (offset >= matchLen)
+            std::memcpy(op, match, matchLen);
+        else
+            //overlapped copy repeats pattern
+            for (size_t i = 0; i < matchLen; ++i)
+                op[i] = match[i];
+        op += matchLen;
+    }
+
+    return op == oend;
+}
+
+} // namespace _Utils
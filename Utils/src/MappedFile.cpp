@@ -0,0 +1,249 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/MappedFile.h"
+#include "utils/logger.h"
+
+#include <algorithm>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <atomic>
+    #include <mutex>
+    #include <csignal>
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace _Utils
+{
+
+#ifndef WIN32
+//mapped ranges are checked in signal handler, so they are kept in fixed array of atomics
+struct MapRange
+{
+    std::atomic<const char*>    begin{};
+    std::atomic<size_t>         size{};
+    std::atomic_bool            fault{};
+};
+
+static const size_t     c_maxRanges{ 64 };
+static MapRange         s_ranges[c_maxRanges];
+static uintptr_t        s_pageSize{};
+static struct sigaction s_prevBus{};
+
+static void OnSigBus(int sig, siginfo_t* info, void* context)
+{
+    auto addr{ static_cast<const char*>(info->si_addr) };
+    for (auto& range : s_ranges)
+    {
+        auto begin{ range.begin.load() };
+        if (!begin || addr < begin || addr >= begin + range.size.load())
+            continue;
+
+        //page after the end of truncated file is replaced by zero page and reading is repeated
+        auto page{ reinterpret_cast<uintptr_t>(addr) & ~(s_pageSize - 1) };
+        if (mmap(reinterpret_cast<void*>(page), s_pageSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+        {
+            range.fault = true;
+            return;
+        }
+        break;
+    }
+
+    //fault is not in mapped file
+    if ((s_prevBus.sa_flags & SA_SIGINFO) && s_prevBus.sa_sigaction)
+        s_prevBus.sa_sigaction(sig, info, context);
+    else if (s_prevBus.sa_handler != SIG_DFL && s_prevBus.sa_handler != SIG_IGN)
+        s_prevBus.sa_handler(sig);
+    else
+    {
+        signal(SIGBUS, SIG_DFL);
+        raise(SIGBUS);
+    }
+}
+
+static int AddRange(const char* data, size_t size)
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        s_pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        struct sigaction action{};
+        action.sa_sigaction = OnSigBus;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGBUS, &action, &s_prevBus) != 0)
+            LOG(ERROR) << __FUNC__ << " sigaction errno=" << errno;
+    });
+
+    for (size_t n = 0; n < c_maxRanges; ++n)
+    {
+        //slot is taken by size, begin is set after it, so handler sees whole range
+        size_t empty{};
+        if (!s_ranges[n].size.compare_exchange_strong(empty, size))
+            continue;
+        s_ranges[n].fault = false;
+        s_ranges[n].begin = data;
+        return static_cast<int>(n);
+    }
+
+    LOG(ERROR) << __FUNC__ << " too many mapped files";
+    return -1;
+}
+
+static void RemoveRange(int slot)
+{
+    if (slot < 0)
+        return;
+    s_ranges[slot].begin = nullptr;
+    s_ranges[slot].size = 0;
+}
+#endif
+
+bool MappedFile::Open(const std::filesystem::path& file)
+{
+    Close();
+
+#ifdef WIN32
+    HANDLE hFile = CreateFileW(file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0 || static_cast<uint64_t>(size.QuadPart) > SIZE_MAX)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMap = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!hMap)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto data = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(hMap);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_file = hFile;
+    m_map = hMap;
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || static_cast<uint64_t>(st.st_size) > SIZE_MAX)
+    {
+        close(fd);
+        return false;
+    }
+
+    auto data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    //mapping stays valid after closing of file
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        LOG(ERROR) << __FUNC__ << "mmap errno=" << errno;
+        return false;
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<size_t>(st.st_size);
+    m_slot = AddRange(m_data, m_size);
+#endif
+
+    LOG(DEBUG) << "MappedFile " << file.u8string() << " size=" << m_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!m_data)
+        return;
+
+#ifdef WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_map);
+    CloseHandle(m_file);
+    m_map = nullptr;
+    m_file = nullptr;
+#else
+    RemoveRange(m_slot);
+    m_slot = -1;
+    munmap(const_cast<char*>(m_data), m_size);
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+std::string_view MappedFile::GetView(uint64_t offset, size_t size) const
+{
+    if (!m_data || offset > m_size || size > m_size - offset)
+        return {};
+
+    return {m_data + offset, size};
+}
+
+bool MappedFile::IsTruncated() const
+{
+#ifdef WIN32
+    //mapped file can't be truncated
+    return false;
+#else
+    return m_slot >= 0 && s_ranges[m_slot].fault;
+#endif
+}
+
+void MappedFile::Prefetch([[maybe_unused]] uint64_t offset, [[maybe_unused]] size_t size) const
+{
+#ifndef WIN32
+    if (!m_data || offset >= m_size)
+        return;
+
+    //madvise needs page aligned address
+    static const uint64_t pageSize{ static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) };
+    uint64_t begin{ offset - offset % pageSize };
+    uint64_t end{ std::min(static_cast<uint64_t>(m_size), offset + size) };
+    madvise(const_cast<char*>(m_data + begin), static_cast<size_t>(end - begin), MADV_WILLNEED);
+#endif
+}
+
+} //namespace _Utils
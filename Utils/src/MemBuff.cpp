@@ -25,6 +25,8 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "utils/MemBuff.h"
+#include "utils/Directory.h"
+#include "utils/Lz.h"
 #include "utils/logger.h"
 
 
@@ -39,58 +41,362 @@ template <typename Tbuff>
 BuffPool<Tbuff>::BuffPool(size_t n)
 {
     m_stepBlocks = n;
+    AddBlocks(n);
+}
 
-    if (n > m_blockArray.size())
-        n = m_blockArray.size();
+template <typename Tbuff>
+BuffPool<Tbuff>::~BuffPool()
+{
+    if (m_swapFile.is_open())
+    {
+        m_swapFile.close();
+        std::error_code ec;
+        std::filesystem::remove(m_swapName, ec);
+    }
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::AddBlocks(size_t n)
+{
+    m_blockArray.resize(m_usedBlocks + n);
+    m_links.resize(m_usedBlocks + n);
 
     for (size_t i = 0; i < n; ++i)
     {
-        m_blockPool.emplace_back(i);
+        PushBack(static_cast<uint32_t>(m_usedBlocks));
         ++m_usedBlocks;
     }
 }
 
 template <typename Tbuff>
-hbuff_t BuffPool<Tbuff>::GetFreeBuff()
+void BuffPool<Tbuff>::FreeMemory(uint32_t index)
+{
+    auto& ptr = m_blockArray[index];
+    if (ptr)
+    {
+        m_allocSize -= m_links[index].size;
+        ptr.reset();
+    }
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::FreeBlock(uint32_t index)
+{
+    //block is taken from owner and its memory is returned
+    auto& link = m_links[index];
+    if (link.owned)
+        m_ownedSize -= link.size;
+    link.owned = false;
+    link.dirty = false;
+    ++link.version;
+    FreeMemory(index);
+    Unlink(index);
+    PushBack(index);
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::PushFront(uint32_t index)
+{
+    auto& link = m_links[index];
+    link.prev = c_nil;
+    link.next = m_head;
+    link.linked = true;
+    if (m_head != c_nil)
+        m_links[m_head].prev = index;
+    else
+        m_tail = index;
+    m_head = index;
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::PushBack(uint32_t index)
+{
+    auto& link = m_links[index];
+    link.prev = m_tail;
+    link.next = c_nil;
+    link.linked = true;
+    if (m_tail != c_nil)
+        m_links[m_tail].next = index;
+    else
+        m_head = index;
+    m_tail = index;
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::Unlink(uint32_t index)
+{
+    auto& link = m_links[index];
+    if (link.prev != c_nil)
+        m_links[link.prev].next = link.next;
+    else
+        m_head = link.next;
+    if (link.next != c_nil)
+        m_links[link.next].prev = link.prev;
+    else
+        m_tail = link.prev;
+    link.prev = link.next = c_nil;
+    link.linked = false;
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::OpenSwap()
+{
+    if (m_swapFile.is_open())
+        return true;
+
+    if (m_swapPath.empty())
+        m_swapPath = Directory::TmpPath("m");
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_swapPath, ec);
+    //path stays directory, so next opening after error uses the same place
+    m_swapName = m_swapPath / ("m-" + std::to_string(reinterpret_cast<uintptr_t>(this)) + "-" + std::to_string(time(nullptr)) + ".swp");
+
+    m_swapFile.open(m_swapName, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!m_swapFile)
+    {
+        LOG(ERROR) << __FUNC__ << "open swap file " << m_swapName.u8string();
+        m_swapFile.clear();
+        return false;
+    }
+    LOG(DEBUG) << "swap file " << m_swapName.u8string();
+
+#ifndef WIN32
+    //file stays accessible only for us
+    std::filesystem::remove(m_swapName, ec);
+#endif
+    return true;
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::SwapOut(uint32_t index)
+{
+    auto& ptr = m_blockArray[index];
+    if (!ptr)
+        return false;
+
+    hbuff_t hbuff{index};
+    hbuff.version = m_links[index].version;
+    if (!SwapOut(SwapKey(hbuff), ptr->data(), ptr->size()))
+        return false;
+
+    m_links[index].dirty = false;
+    return true;
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::SwapOut(uint64_t key, const char* data, size_t size)
 {
-    if (m_blockPool.empty())
+    if (!OpenSwap())
+        return false;
+
+    //swap file is divided to slots of BUFF_SIZE multiple
+    size_t slot = std::max(static_cast<size_t>(BUFF_SIZE), (size + BUFF_SIZE - 1) / BUFF_SIZE * BUFF_SIZE);
+    uint64_t offset;
+    if (auto free = m_swapFree.lower_bound(slot); free != m_swapFree.end())
     {
-        if (m_usedBlocks >= m_blockArray.size())
+        slot = free->first;
+        offset = free->second;
+        m_swapFree.erase(free);
+    }
+    else
+    {
+        offset = m_swapEnd;
+        m_swapEnd += slot;
+    }
+
+    m_swapFile.seekp(offset);
+    m_swapFile.write(data, size);
+    if (!m_swapFile)
+    {
+        LOG(ERROR) << __FUNC__ << "write swap file";
+        m_swapFile.clear();
+        m_swapFree.emplace(slot, offset);
+        return false;
+    }
+
+    m_swapMap[key] = {offset, size, slot};
+    ++m_stat.spills;
+
+    return true;
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::FreeSwap(uint64_t key)
+{
+    auto it = m_swapMap.find(key);
+    if (it == m_swapMap.end())
+        return;
+
+    m_swapFree.emplace(it->second.slot, it->second.offset);
+    m_swapMap.erase(it);
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::Pack(uint32_t index)
+{
+    auto& ptr = m_blockArray[index];
+    if (m_maxPackSize == 0 || !ptr || ptr->empty())
+        return false;
+
+    PackEntry entry;
+    if (!Lz::Compress(ptr->data(), ptr->size(), entry.data))
+        return false;
+    entry.data.shrink_to_fit();
+    entry.size = ptr->size();
+    entry.dirty = m_links[index].dirty;
+
+    hbuff_t hbuff{index};
+    hbuff.version = m_links[index].version;
+    auto key = SwapKey(hbuff);
+
+    m_packSize += entry.data.size();
+    m_packMap.emplace(key, std::move(entry));
+    m_packQueue.push_back(key);
+    m_links[index].dirty = false;
+    ++m_stat.packs;
+
+    TrimPack();
+    return true;
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::TrimPack()
+{
+    while (m_packSize > m_maxPackSize && !m_packQueue.empty())
+    {
+        auto key = m_packQueue.front();
+        auto it = m_packMap.find(key);
+        if (it != m_packMap.end() && it->second.dirty)
         {
-            _assert(!"No free blocks");
-            return {};
+            //modified block must be saved to swap file
+            Tbuff buff(it->second.size, 0);
+            if (!Lz::Decompress(it->second.data.data(), it->second.data.size(), buff.data(), buff.size())
+                || !SwapOut(key, buff.data(), buff.size()))
+                break;
         }
 
-        for (size_t i = 0; i < m_stepBlocks && m_usedBlocks < m_blockArray.size(); ++i)
+        m_packQueue.pop_front();
+        FreePack(key);
+    }
+
+    if (m_packQueue.size() > 2 * m_packMap.size() + STEP_BLOCKS)
+    {
+        //remove keys of restored blocks
+        std::deque<uint64_t> queue;
+        for (auto key : m_packQueue)
+            if (m_packMap.find(key) != m_packMap.end())
+                queue.push_back(key);
+        m_packQueue.swap(queue);
+    }
+}
+
+template <typename Tbuff>
+void BuffPool<Tbuff>::FreePack(uint64_t key)
+{
+    auto it = m_packMap.find(key);
+    if (it == m_packMap.end())
+        return;
+
+    m_packSize -= it->second.data.size();
+    m_packMap.erase(it);
+}
+
+template <typename Tbuff>
+uint32_t BuffPool<Tbuff>::GetVictim()
+{
+    //the last used block is compressed in memory, or modified block must be saved to swap
+    for (uint32_t index = m_tail; index != c_nil; index = m_links[index].prev)
+        if (m_links[index].owned && (Pack(index) || !m_links[index].dirty || SwapOut(index)))
+            return index;
+
+    return c_nil;
+}
+
+template <typename Tbuff>
+hbuff_t BuffPool<Tbuff>::GetFreeBuff(size_t size)
+{
+    std::lock_guard lock{m_mutex};
+    uint32_t index{c_nil};
+    while (m_ownedSize + size > m_maxSize)
+    {
+        //memory limit is reached, take block from last used owner
+        auto victim = GetVictim();
+        if (victim == c_nil)
         {
-            m_blockPool.emplace_back(m_usedBlocks);
-            ++m_usedBlocks;
+            //all blocks are pinned or cannot be saved
+            LOG(DEBUG) << "All blocks are used, memory limit is exceeded";
+            break;
         }
+
+        ++m_stat.evictions;
+        if (m_links[victim].size == size)
+        {
+            index = victim;
+            break;
+        }
+        //block of other size is returned to pool
+        FreeBlock(victim);
     }
 
-    hbuff_t hbuff = m_blockPool.back();
-    ++hbuff.version;
+    if (index == c_nil)
+    {
+        if (m_tail == c_nil || m_links[m_tail].owned)
+            //no free blocks, add new ones
+            AddBlocks(m_stepBlocks);
+        index = m_tail;
+    }
 
-    m_blockPool.pop_back();
-    m_blockPool.push_front(hbuff);
+    auto& link = m_links[index];
+    if (link.size != static_cast<uint32_t>(size))
+    {
+        FreeMemory(index);
+        link.size = static_cast<uint32_t>(size);
+    }
+    if (!link.owned)
+        m_ownedSize += size;
+    link.owned = true;
+    link.dirty = false;
+    ++link.version;
+
+    Unlink(index);
+    PushFront(index);
 
+    hbuff_t hbuff{index};
+    hbuff.version = link.version;
     return hbuff;
 }
 
 template <typename Tbuff>
 bool BuffPool<Tbuff>::ReleaseBuff(hbuff_t hbuff)
 {
+    std::lock_guard lock{m_mutex};
     if (hbuff.index >= m_usedBlocks)
         return false;
 
-    for (auto it = m_blockPool.cbegin(); it != m_blockPool.cend(); ++it)
+    if (IsResident(hbuff))
     {
-        if (*it == hbuff)
+        //block is free now, it will be used first
+        uint32_t index = static_cast<uint32_t>(hbuff.index);
+        auto& link = m_links[index];
+        if (link.owned)
+            m_ownedSize -= link.size;
+        link.owned = false;
+        link.dirty = false;
+        if (link.linked)
         {
-            m_blockPool.erase(it);
-            m_blockPool.push_front(hbuff);
-            break;
+            if (m_allocSize > m_maxSize)
+                //return memory over limit
+                FreeMemory(index);
+            Unlink(index);
+            PushBack(index);
         }
+        //pinned block will be free after the last unpin
+    }
+    else
+    {
+        FreePack(SwapKey(hbuff));
+        FreeSwap(SwapKey(hbuff));
     }
 
     return true;
@@ -99,47 +405,231 @@ bool BuffPool<Tbuff>::ReleaseBuff(hbuff_t hbuff)
 template <typename Tbuff>
 std::shared_ptr<Tbuff> BuffPool<Tbuff>::GetBuffPointer(hbuff_t hbuff)
 {
+    std::lock_guard lock{m_mutex};
     if (hbuff.index >= m_usedBlocks)
         return nullptr;
 
-    bool found{false};
-    for (auto it = m_blockPool.cbegin(); it != m_blockPool.cend(); ++it)
+    if (!IsResident(hbuff))
     {
-        if (*it == hbuff)
-        {
-            m_blockPool.erase(it);
-            found = true;
-            break;
-        }
-    }
-    if (!found)
         //block was lost
+        ++m_stat.misses;
         return nullptr;
+    }
 
+    ++m_stat.hits;
+    auto& link = m_links[hbuff.index];
+    ++link.pins;
     auto& ptr = m_blockArray[hbuff.index];
+    if (!link.linked)
+        //block is already pinned
+        return ptr;
+
+    Unlink(static_cast<uint32_t>(hbuff.index));
     if (!ptr)
+    {
         ptr = std::make_shared<Tbuff>();
+        m_allocSize += link.size;
+    }
     if (ptr)
-        ptr->reserve(BUFF_SIZE);
+        ptr->reserve(link.size);
     return ptr;
 }
 
 template <typename Tbuff>
-bool BuffPool<Tbuff>::ReleaseBuffPointer(hbuff_t hbuff)
+void BuffPool<Tbuff>::Unpin(uint32_t index)
+{
+    auto& link = m_links[index];
+    if (--link.pins != 0)
+        return;
+
+    if (link.owned)
+        PushFront(index);
+    else
+    {
+        //owner released block while it was pinned
+        if (m_allocSize > m_maxSize)
+            FreeMemory(index);
+        PushBack(index);
+    }
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::ReleaseBuffPointer(hbuff_t hbuff, bool dirty)
+{
+    std::lock_guard lock{m_mutex};
+    if (hbuff.index >= m_usedBlocks)
+        return false;
+
+    auto index = static_cast<uint32_t>(hbuff.index);
+    if (m_links[index].pins == 0 || m_links[index].version != hbuff.version)
+        return false;
+
+    m_links[index].dirty = dirty;
+    Unpin(index);
+    return true;
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::UnpinBuff(hbuff_t hbuff)
 {
+    std::lock_guard lock{m_mutex};
     if (hbuff.index >= m_usedBlocks)
         return false;
 
-    m_blockPool.push_front(hbuff);
+    auto index = static_cast<uint32_t>(hbuff.index);
+    if (m_links[index].pins == 0 || m_links[index].version != hbuff.version)
+        return false;
+
+    Unpin(index);
     return true;
 }
 
+template <typename Tbuff>
+bool BuffPool<Tbuff>::ReadStored(uint64_t key, Tbuff& buff)
+{
+    if (auto pack = m_packMap.find(key); pack != m_packMap.end())
+    {
+        buff.resize(pack->second.size);
+        if (!Lz::Decompress(pack->second.data.data(), pack->second.data.size(), buff.data(), buff.size()))
+        {
+            LOG(ERROR) << __FUNC__ << "decompress block";
+            _assert(0);
+            return false;
+        }
+        return true;
+    }
+
+    auto it = m_swapMap.find(key);
+    if (it == m_swapMap.end())
+        return false;
+
+    buff.resize(it->second.size);
+    m_swapFile.seekg(it->second.offset);
+    m_swapFile.read(buff.data(), it->second.size);
+    if (!m_swapFile)
+    {
+        LOG(ERROR) << __FUNC__ << "read swap file";
+        m_swapFile.clear();
+        _assert(0);
+    }
+    return true;
+}
+
+template <typename Tbuff>
+bool BuffPool<Tbuff>::RestoreBuff(hbuff_t hbuff, std::shared_ptr<Tbuff> buff)
+{
+    std::lock_guard lock{m_mutex};
+    if (!buff)
+        return false;
+
+    auto key = SwapKey(hbuff);
+    if (m_packMap.count(key))
+    {
+        bool rc = ReadStored(key, *buff);
+        FreePack(key);
+        if (rc)
+            ++m_stat.unpacks;
+        return rc;
+    }
+
+    if (!ReadStored(key, *buff))
+        return false;
+    FreeSwap(key);
+    ++m_stat.restores;
+    return true;
+}
+
+template <typename Tbuff>
+std::shared_ptr<Tbuff> BuffPool<Tbuff>::CopyBuff(hbuff_t hbuff)
+{
+    std::lock_guard lock{m_mutex};
+    auto key = SwapKey(hbuff);
+    if (!m_packMap.count(key) && !m_swapMap.count(key))
+        return nullptr;
+
+    //owner restores block from the same place later
+    auto buff = std::make_shared<Tbuff>();
+    if (!ReadStored(key, *buff))
+        return nullptr;
+    return buff;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 template <typename Tbuff, typename Tview>
 bool SBuff<Tbuff, Tview>::Clear()
 {
     m_strOffsetList.clear();
     m_mod = false;
+    m_gapStr = c_noGap;
+    m_gapSize = 0;
+    m_dataSize = 0;
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+void SBuff<Tbuff, Tview>::MoveGap(size_t n)
+{
+    if (m_gapStr == c_noGap)
+    {
+        //open empty gap at the end of data
+        m_dataSize = GetBuffSize();
+        m_gapStr = static_cast<uint32_t>(GetStrCount());
+        m_gapSize = 0;
+    }
+
+    auto data = m_buff->data();
+    if (n < m_gapStr)
+    {
+        //move strings from begin of gap to end
+        uint32_t begin = GetStrOffset(n);
+        uint32_t end = GetStrOffset(m_gapStr);
+        std::memmove(data + begin + m_gapSize, data + begin, end - begin);
+        for (size_t i = n; i < m_gapStr; ++i)
+            m_strOffsetList.Set(i, m_dataSize - m_strOffsetList[i]);
+    }
+    else if (n > m_gapStr)
+    {
+        //move strings from end of gap to begin
+        uint32_t begin = GetStrOffset(m_gapStr);
+        uint32_t end = GetStrOffset(n);
+        std::memmove(data + begin, data + begin + m_gapSize, end - begin);
+        for (size_t i = m_gapStr; i < n; ++i)
+            m_strOffsetList.Set(i, m_dataSize - m_strOffsetList[i]);
+    }
+
+    m_gapStr = static_cast<uint32_t>(n);
+}
+
+template <typename Tbuff, typename Tview>
+bool SBuff<Tbuff, Tview>::ReserveGap(uint32_t size)
+{
+    if (m_gapSize >= size)
+        return true;
+
+    size_t capacity = m_buff->capacity();
+    if (static_cast<size_t>(m_dataSize) + size > capacity)
+        return false;
+
+    //add more space for next edits but not over buffer capacity
+    size_t add = std::min(static_cast<size_t>(size - m_gapSize + c_gapStep), capacity - m_dataSize - m_gapSize);
+    m_buff->insert(static_cast<size_t>(GetStrOffset(m_gapStr)) + m_gapSize, add, 0);
+    m_gapSize += static_cast<uint32_t>(add);
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool SBuff<Tbuff, Tview>::CloseGap()
+{
+    if (m_gapStr == c_noGap)
+        return true;
+    if (!m_buff)
+        return false;
+
+    MoveGap(GetStrCount());
+    m_buff->resize(m_dataSize);
+
+    m_gapStr = c_noGap;
+    m_gapSize = 0;
     return true;
 }
 
@@ -154,8 +644,9 @@ Tview SBuff<Tbuff, Tview>::GetStr(size_t n)
 
     auto begin = GetStrOffset(n);
     auto end = GetStrOffset(n + 1);
+    auto gap = n >= m_gapStr ? m_gapSize : 0;
 
-    Tview view(m_buff->c_str() + begin, end - begin);
+    Tview view(m_buff->c_str() + gap + begin, end - begin);
     return view;
 }
 
@@ -165,6 +656,9 @@ bool SBuff<Tbuff, Tview>::AppendStr(const Tview str)
     if (!m_buff)
         return false;
 
+    if (m_gapStr != c_noGap)
+        return AddStr(GetStrCount(), str);
+
     auto offset_end = GetBuffSize();
     uint32_t dl = static_cast<uint32_t>(str.size());
 
@@ -188,23 +682,22 @@ bool SBuff<Tbuff, Tview>::AddStr(size_t n, const Tview str)
     if (n > GetStrCount())
         return false;
 
-    auto offset_n = GetStrOffset(n);
-    auto offset_end = GetBuffSize();
     uint32_t dl = static_cast<uint32_t>(str.size());
+    if (GetBuffSize() + dl > m_buff->capacity())
+        return false;
 
-    if (offset_end + dl > m_buff->capacity())
+    MoveGap(n);
+    if (!ReserveGap(dl))
         return false;
 
-    m_buff->insert(offset_n, str);
+    //put new string to begin of gap
+    auto offset_n = GetStrOffset(n);
+    std::memcpy(m_buff->data() + offset_n, str.data(), dl);
+    m_gapSize -= dl;
+    m_dataSize += dl;
 
-    m_strOffsetList.push_back(0);
-    size_t i;
-    for (i = GetStrCount() - 1; i > n; --i)
-        m_strOffsetList[i] = m_strOffsetList[i - 1] + dl;
-    if (0 != i)
-        m_strOffsetList[i] = m_strOffsetList[i - 1] + dl;
-    else
-        m_strOffsetList[i] = dl;
+    m_strOffsetList.insert(n, offset_n + dl);
+    ++m_gapStr;
 
     m_mod = true;
     return true;
@@ -227,10 +720,15 @@ bool SBuff<Tbuff, Tview>::ChangeStr(size_t n, const Tview str)
     if(dl > 0 && static_cast<size_t>(offset_end) + dl > m_buff->capacity())
         return false;
 
-    m_buff->replace(offset_n, offset_n1 - offset_n, str);
+    //string will be the last before gap
+    MoveGap(n + 1);
+    if (dl > 0 && !ReserveGap(static_cast<uint32_t>(dl)))
+        return false;
 
-    for (size_t i = n; i < GetStrCount(); ++i)
-        m_strOffsetList[i] += dl;
+    std::memcpy(m_buff->data() + offset_n, str.data(), str.size());
+    m_gapSize -= dl;
+    m_dataSize += dl;
+    m_strOffsetList.Set(n, offset_n + static_cast<uint32_t>(str.size()));
 
     m_mod = true;
     return true;
@@ -245,15 +743,15 @@ bool SBuff<Tbuff, Tview>::DelStr(size_t n)
     if (n >= GetStrCount())
         return false;
 
+    //string will be the last before gap and we add it to gap
+    MoveGap(n + 1);
     auto offset_n = GetStrOffset(n);
-    auto offset_n1 = GetStrOffset(n + 1);
-    auto dl = offset_n1 - offset_n;
-
-    m_buff->erase(offset_n, dl);
+    auto dl = m_strOffsetList[n] - offset_n;
 
-    for (size_t i = n; i < GetStrCount() - 1; ++i)
-        m_strOffsetList[i] = m_strOffsetList[i + 1] - dl;
-    m_strOffsetList.pop_back();
+    m_gapSize += dl;
+    m_dataSize -= dl;
+    m_strOffsetList.erase(n);
+    m_gapStr = static_cast<uint32_t>(n);
 
     m_mod = true;
     return true;
@@ -274,25 +772,71 @@ StrBuff<Tbuff, Tview>::~StrBuff()
     }
 }
 
+template <typename Tbuff, typename Tview>
+Tview StrBuff<Tbuff, Tview>::GetStr(size_t n)
+{
+    if (SBuff<Tbuff, Tview>::m_buff || m_mapView.empty())
+        return SBuff<Tbuff, Tview>::GetStr(n);
+
+    if (n >= SBuff<Tbuff, Tview>::GetStrCount())
+        return {};
+
+    auto begin = SBuff<Tbuff, Tview>::GetStrOffset(n);
+    auto end = SBuff<Tbuff, Tview>::GetStrOffset(n + 1);
+    return m_mapView.substr(begin, end - begin);
+}
+
+template <typename Tbuff, typename Tview>
+Tview StrBuff<Tbuff, Tview>::GetStr(const BuffPin<Tbuff>& pin, size_t n) const
+{
+    if (n >= SBuff<Tbuff, Tview>::GetStrCount())
+        return {};
+
+    auto begin = SBuff<Tbuff, Tview>::GetStrOffset(n);
+    auto end = SBuff<Tbuff, Tview>::GetStrOffset(n + 1);
+    if (!pin)
+    {
+        //not modified block dropped from pool is read from mapped file,
+        //else owner has to load block before pinning
+        _assert(!m_mapView.empty());
+        return m_mapView.empty() ? Tview{} : m_mapView.substr(begin, end - begin);
+    }
+
+    auto gap = n >= SBuff<Tbuff, Tview>::m_gapStr ? SBuff<Tbuff, Tview>::m_gapSize : 0;
+    return Tview(pin->c_str() + gap + begin, end - begin);
+}
+
 template <typename Tbuff, typename Tview>
 std::shared_ptr<Tbuff> StrBuff<Tbuff, Tview>::GetBuff()
 {
+    bool newBlock{};
     if (m_buffHandle == 0)
+    {
         //we have no block
-        m_buffHandle = BuffPool<Tbuff>::s_pool.GetFreeBuff();
+        m_buffHandle = BuffPool<Tbuff>::s_pool.GetFreeBuff(m_blockSize);
+        newBlock = true;
+    }
 
     if (!SBuff<Tbuff, Tview>::m_buff)
+    {
         //we have no pointer
         SBuff<Tbuff, Tview>::m_buff = BuffPool<Tbuff>::s_pool.GetBuffPointer(m_buffHandle);
+        if (SBuff<Tbuff, Tview>::m_buff && newBlock)
+            //block can keep data of previous owner
+            SBuff<Tbuff, Tview>::m_buff->clear();
+    }
 
     if (!SBuff<Tbuff, Tview>::m_buff)
     {
         //we lost buffer
-        m_buffHandle = BuffPool<Tbuff>::s_pool.GetFreeBuff();
+        hbuff_t lost = m_buffHandle;
+        m_buffHandle = BuffPool<Tbuff>::s_pool.GetFreeBuff(m_blockSize);
         if (m_buffHandle != 0)
         {
             SBuff<Tbuff, Tview>::m_buff = BuffPool<Tbuff>::s_pool.GetBuffPointer(m_buffHandle);
-            m_lostData = true;
+            //block was compressed or saved to swap file, otherwise it will be reloaded
+            if (!BuffPool<Tbuff>::s_pool.RestoreBuff(lost, SBuff<Tbuff, Tview>::m_buff))
+                m_lostData = true;
         }
     }
 
@@ -303,14 +847,34 @@ template <typename Tbuff, typename Tview>
 bool StrBuff<Tbuff, Tview>::ReleaseBuff()
 {
     bool rc = true;
-    if (SBuff<Tbuff, Tview>::m_buff && !SBuff<Tbuff, Tview>::m_mod)
+    if (SBuff<Tbuff, Tview>::m_buff)
     {
-        rc = BuffPool<Tbuff>::s_pool.ReleaseBuffPointer(m_buffHandle);
+        rc = BuffPool<Tbuff>::s_pool.ReleaseBuffPointer(m_buffHandle, SBuff<Tbuff, Tview>::m_mod);
         SBuff<Tbuff, Tview>::m_buff = nullptr;
     }
     return rc;
 }
 
+template <typename Tbuff, typename Tview>
+bool StrBuff<Tbuff, Tview>::DropBuff()
+{
+    //not modified data can be loaded again from file
+    if (SBuff<Tbuff, Tview>::m_mod)
+        return false;
+
+    bool rc = true;
+    if (SBuff<Tbuff, Tview>::m_buff)
+        rc = BuffPool<Tbuff>::s_pool.ReleaseBuffPointer(m_buffHandle);
+    if (m_buffHandle != 0)
+        rc = BuffPool<Tbuff>::s_pool.ReleaseBuff(m_buffHandle);
+
+    m_buffHandle = 0;
+    SBuff<Tbuff, Tview>::m_buff = nullptr;
+    m_lostData = true;
+
+    return rc;
+}
+
 template <typename Tbuff, typename Tview>
 bool StrBuff<Tbuff, Tview>::Clear()
 {
@@ -325,6 +889,7 @@ bool StrBuff<Tbuff, Tview>::Clear()
 
     m_fileOffset = 0;
     m_lostData = false;
+    m_mapView = {};
 
     return rc;
 }
@@ -334,8 +899,10 @@ bool StrBuff<Tbuff, Tview>::ClearModifyFlag()
 {
     bool rc = true;
     SBuff<Tbuff, Tview>::m_mod = false;
+    m_mapView = {};
     if (SBuff<Tbuff, Tview>::m_buff)
     {
+        SBuff<Tbuff, Tview>::CloseGap();
         rc = BuffPool<Tbuff>::s_pool.ReleaseBuffPointer(m_buffHandle);
         SBuff<Tbuff, Tview>::m_buff = nullptr;
     }
@@ -344,99 +911,99 @@ bool StrBuff<Tbuff, Tview>::ClearModifyFlag()
 
 /////////////////////////////////////////////////////////////////////////////
 template <typename Tbuff, typename Tview>
-MemStrBuff<Tbuff, Tview>::MemStrBuff()
-{
-    m_curBuff = m_buffList.end();
-}
-
-template <typename Tbuff, typename Tview>
-std::optional<typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator> MemStrBuff<Tbuff, Tview>::GetBuff(size_t& line)
+std::optional<typename MemStrBuff<Tbuff, Tview>::BuffList::iterator> MemStrBuff<Tbuff, Tview>::GetBuff(size_t& line, bool write)
 {
     if (m_buffList.empty())
     {
-        auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>();
+        auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>(m_blockSize);
         m_buffList.push_back(newBuff);
-        m_curBuff = m_buffList.begin();
     }
 
     if (line > m_totalStrCount)
         return std::nullopt;
 
-    if (m_curBuff == m_buffList.end() && m_curBuffLine == 0)
-    {
-        m_curBuff = m_buffList.begin();
-        m_curBuffLine = 0;
-    }
+    auto [buff, firstLine] = m_buffList.Find(line);
+    m_curBuff = *buff;
 
-    if (line < m_curBuffLine)
-    {
-        //LOG(DEBUG) << "GetBuff prev l=" << line;
-        while (m_curBuff != m_buffList.begin())
-        {
-            --m_curBuff;
-            //m_curBuffLine -= (*m_curBuff)->m_strCount;
-            m_curBuffLine -= (*m_curBuff)->GetStrCount();
-            if (line > m_curBuffLine)
-                break;
-        }
-    }
-    else if (line >= m_curBuffLine + (*m_curBuff)->GetStrCount())
-    {
-        //LOG(DEBUG) << "GetBuff next l=" << line;
-        while (m_curBuff != m_buffList.end())
-        {
-            auto count = (*m_curBuff)->GetStrCount();
-            ++m_curBuff;
-            if (m_curBuff == m_buffList.end())
-            {
-                --m_curBuff;
-                break;
-            }
-            m_curBuffLine += count;
-            if (line < m_curBuffLine + (*m_curBuff)->GetStrCount())
-                break;
-        }
-    }
-
-    auto blockBuff = (*m_curBuff)->GetBuff();
+    auto blockBuff = m_curBuff->GetBuff();
     if (!blockBuff)
     {
         _assert(!"no memory");
         return std::nullopt;
     }
 
-    if ((*m_curBuff)->m_lostData)
+    if (m_curBuff->m_lostData)
     {
-        //LOG(DEBUG) << "curBuff->m_lostData first=" << m_curBuffLine << " last=" << m_curBuffLine + (*m_curBuff)->GetStrCount() - 1;
+        //LOG(DEBUG) << "curBuff->m_lostData first=" << firstLine << " last=" << firstLine + m_curBuff->GetStrCount() - 1;
 
-        bool rc = LoadBuff((*m_curBuff)->m_fileOffset, (*m_curBuff)->GetBuffSize(), (*m_curBuff)->GetBuff());
+        bool rc = LoadBuff(m_curBuff->m_fileOffset, m_curBuff->GetBuffSize(), m_curBuff->GetBuff());
         if (!rc)
             return std::nullopt;
 
-        (*m_curBuff)->m_lostData = false;
+        m_curBuff->m_lostData = false;
     }
 
-    line -= m_curBuffLine;
+    if (write && !Detach(buff))
+        return std::nullopt;
+
+    line -= firstLine;
     //don't forgot to call release buffer in external function after buffer using
     //m_curBuff->ReleaseBuff();
 
-    return m_curBuff;
+    return buff;
 }
 
 template <typename Tbuff, typename Tview>
-std::shared_ptr<StrBuff<Tbuff, Tview>> MemStrBuff<Tbuff, Tview>::GetNewBuff()
-{ 
-    auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>();
-    m_buffList.push_back(newBuff);
-    return newBuff;
+bool MemStrBuff<Tbuff, Tview>::Detach(typename BuffList::iterator buff)
+{
+    auto oldBuff = *buff;
+    if (!oldBuff->m_shared)
+        return true;
+
+    //snapshot keeps old block, copy of it is changed
+    auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>(oldBuff->m_blockSize);
+    auto oldBuffData = oldBuff->GetBuff();
+    auto newBuffData = newBuff->GetBuff();
+    if (!oldBuffData || !newBuffData)
+    {
+        oldBuff->ReleaseBuff();
+        newBuff->ReleaseBuff();
+
+        LOG(ERROR) << __FUNC__ << "ERROR GetBuff";
+        return false;
+    }
+
+    *newBuffData = *oldBuffData;
+    newBuff->m_strOffsetList = oldBuff->m_strOffsetList;
+    newBuff->m_gapStr = oldBuff->m_gapStr;
+    newBuff->m_gapSize = oldBuff->m_gapSize;
+    newBuff->m_dataSize = oldBuff->m_dataSize;
+    newBuff->m_fileOffset = oldBuff->m_fileOffset;
+    //offset of copy in saved file is unknown, so it is written with next saving
+    newBuff->m_mod = true;
+
+    oldBuff->m_shared = false;
+    oldBuff->ReleaseBuff();
+    *buff = newBuff;
+    m_curBuff = newBuff;
+
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool MemStrBuff<Tbuff, Tview>::AppendBuff(std::shared_ptr<StrBuff<Tbuff, Tview>> buff)
+{
+    m_buffList.push_back(buff);
+    m_totalStrCount += buff->GetStrCount();
+    return true;
 }
 
 template <typename Tbuff, typename Tview>
 bool MemStrBuff<Tbuff, Tview>::ReleaseBuff()
 {
-    if (m_curBuff != m_buffList.end())
+    if (m_curBuff)
     {
-        (*m_curBuff)->ReleaseBuff();
+        m_curBuff->ReleaseBuff();
     }
     return true;
 }
@@ -454,6 +1021,26 @@ size_t MemStrBuff<Tbuff, Tview>::GetSize() const
     return size;
 }
 
+template <typename Tbuff, typename Tview>
+MemStat MemStrBuff<Tbuff, Tview>::GetMemStat() const
+{
+    MemStat stat;
+    for (const auto& buff : m_buffList)
+    {
+        ++stat.blocks;
+        stat.strings += buff->GetStrCount();
+        stat.dataSize += buff->GetBuffSize();
+        stat.offsetSize += buff->m_strOffsetList.GetMemSize();
+        if (buff->m_strOffsetList.IsWide())
+            ++stat.wideBlocks;
+        if (BuffPool<Tbuff>::s_pool.IsOwned(buff->m_buffHandle))
+            stat.poolSize += buff->m_blockSize;
+    }
+    stat.infoSize = stat.blocks * sizeof(StrBuff<Tbuff, Tview>);
+
+    return stat;
+}
+
 template <typename Tbuff, typename Tview>
 bool MemStrBuff<Tbuff, Tview>::ClearModifyFlag()
 {
@@ -465,14 +1052,21 @@ bool MemStrBuff<Tbuff, Tview>::ClearModifyFlag()
     return true;
 }
 
+template <typename Tbuff, typename Tview>
+bool MemStrBuff<Tbuff, Tview>::ResetMapping()
+{
+    for (auto& buff : m_buffList)
+        buff->m_mapView = {};
+    return true;
+}
+
 template <typename Tbuff, typename Tview>
 bool MemStrBuff<Tbuff, Tview>::Clear()
 {
     m_buffList.clear();
-    m_curBuff = m_buffList.end();
+    m_curBuff = nullptr;
     m_totalStrCount = 0;
     m_changed = false;
-    m_curBuffLine = 0;
 
     return true;
 }
@@ -483,6 +1077,20 @@ Tview MemStrBuff<Tbuff, Tview>::GetStr(size_t n)
     if (n >= m_totalStrCount)
         return {};
 
+    if (m_mapBuffFunc)
+    {
+        //not modified block without data in pool is read from mapped file without copying
+        auto [mapBuff, firstLine] = m_buffList.Find(n);
+        auto& strBuff = *mapBuff;
+        if (!strBuff->m_buff && !strBuff->m_mod)
+        {
+            if (strBuff->m_mapView.empty())
+                strBuff->m_mapView = m_mapBuffFunc(strBuff->m_fileOffset, strBuff->GetBuffSize());
+            if (strBuff->m_mapView.size() == strBuff->GetBuffSize() && !strBuff->m_mapView.empty())
+                return strBuff->GetStr(n - firstLine);
+        }
+    }
+
     auto buff = GetBuff(n);
     if (!buff || n > (**buff)->GetStrCount())
         return {};
@@ -491,7 +1099,7 @@ Tview MemStrBuff<Tbuff, Tview>::GetStr(size_t n)
 }
 
 template <typename Tbuff, typename Tview>
-bool MemStrBuff<Tbuff, Tview>::SplitBuff(typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator buff, size_t line)
+bool MemStrBuff<Tbuff, Tview>::SplitBuff(typename BuffList::iterator buff, size_t line)
 {
     _assert(buff != m_buffList.end());
 
@@ -499,24 +1107,25 @@ bool MemStrBuff<Tbuff, Tview>::SplitBuff(typename std::list<std::shared_ptr<StrB
     size_t offset = oldBuff->GetStrOffset(line);
     size_t split = 0;
 
+    size_t blockSize = oldBuff->m_blockSize;
     size_t limit;
-    if (offset < BUFF_SIZE / 3)
+    if (offset < blockSize / 3)
         // 1/3
-        limit = BUFF_SIZE / 3;
-    else if (offset < (BUFF_SIZE / 3) * 2)
+        limit = blockSize / 3;
+    else if (offset < (blockSize / 3) * 2)
         // 1/2
-        limit = BUFF_SIZE / 2;
+        limit = blockSize / 2;
     else
         // 2/3
-        limit = (BUFF_SIZE / 3) * 2;
+        limit = (blockSize / 3) * 2;
 
     for (split = 0; oldBuff->GetStrOffset(split) < limit; ++split);
 
-    auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>();
+    auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>(blockSize);
 
     auto oldBuffData = oldBuff->GetBuff();
     auto newBuffData = newBuff->GetBuff();
-    if (!oldBuffData || !newBuffData)
+    if (!oldBuffData || !newBuffData || !oldBuff->CloseGap())
     {
         oldBuff->ReleaseBuff();
         newBuff->ReleaseBuff();
@@ -537,9 +1146,10 @@ bool MemStrBuff<Tbuff, Tview>::SplitBuff(typename std::list<std::shared_ptr<StrB
     for (size_t i = 1; i + split <= oldBuff->GetStrCount(); ++i)
         newBuff->m_strOffsetList.push_back((oldBuff->GetStrOffset(i + split) - begin));
 
-    oldBuff->m_strOffsetList.erase(oldBuff->m_strOffsetList.begin() + split, oldBuff->m_strOffsetList.end());
+    oldBuff->m_strOffsetList.resize(split);
     oldBuffData->resize(begin);
 
+    m_buffList.Update(buff);
     m_buffList.insert(++buff, newBuff);
 
     //LOG(DEBUG) << "n=" << oldBuff->m_strCount << " old=" << split << " new=" << newBuff->m_strCount;
@@ -559,12 +1169,12 @@ bool MemStrBuff<Tbuff, Tview>::SplitBuff(typename std::list<std::shared_ptr<StrB
 }
 
 template <typename Tbuff, typename Tview>
-bool MemStrBuff<Tbuff, Tview>::DelBuff(typename std::list<std::shared_ptr<StrBuff<Tbuff, Tview>>>::iterator& buff)
+bool MemStrBuff<Tbuff, Tview>::DelBuff(typename BuffList::iterator& buff)
 {
-    if (buff == m_curBuff)
-        m_curBuff = m_buffList.end();
+    if (*buff == m_curBuff)
+        m_curBuff = nullptr;
 
-    m_buffList.erase(buff);
+    buff = m_buffList.erase(buff);
     return true;
 }
 
@@ -576,14 +1186,13 @@ bool MemStrBuff<Tbuff, Tview>::AddStr(size_t n, const Tview str)
 
     //LOG(DEBUG) << "AddStr n=" << n << " '" << str << "'";
 
-    auto buff = GetBuff(n);
+    size_t _n = n;
+    auto buff = GetBuff(n, true);
     if (!buff)
     {
         _assert(0);
         return false;
     }
-        
-    size_t _n = n;
 
     bool rc = (**buff)->AddStr(n, str);
     if (!rc)
@@ -591,10 +1200,10 @@ bool MemStrBuff<Tbuff, Tview>::AddStr(size_t n, const Tview str)
         if (n == (**buff)->GetStrCount())
         {
             //LOG(DEBUG) << "Last line " << _n << ". Create new buff=" << m_buffList.size();
-            auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>();
+            auto newBuff = std::make_shared<StrBuff<Tbuff, Tview>>(m_blockSize);
             m_buffList.push_back(newBuff);
             n = _n;
-            buff = GetBuff(n);
+            buff = GetBuff(n, true);
             if (!buff)
             {
                 _assert(0);
@@ -609,7 +1218,7 @@ bool MemStrBuff<Tbuff, Tview>::AddStr(size_t n, const Tview str)
             if (rc)
             {
                 n = _n;
-                buff = GetBuff(n);
+                buff = GetBuff(n, true);
                 if (!buff)
                 {
                     _assert(0);
@@ -621,7 +1230,10 @@ bool MemStrBuff<Tbuff, Tview>::AddStr(size_t n, const Tview str)
     }
 
     if (rc)
+    {
         ++m_totalStrCount;
+        m_buffList.Update(*buff);
+    }
 
     if (buff)
         (**buff)->ReleaseBuff();
@@ -639,20 +1251,19 @@ bool MemStrBuff<Tbuff, Tview>::ChangeStr(size_t n, const Tview str)
     if (n >= m_totalStrCount)
         return false;
 
-    auto buff = GetBuff(n);
+    size_t _n = n;
+    auto buff = GetBuff(n, true);
     if (!buff)
         return false;
 
-    size_t _n = n;
-
     bool rc = (**buff)->ChangeStr(n, str);
     if (!rc)
     {
         rc = SplitBuff(*buff, n);
-        if (!rc)
+        if (rc)
         {
             n = _n;
-            buff = GetBuff(n);
+            buff = GetBuff(n, true);
             if (!buff)
                 rc = false;
             else
@@ -678,7 +1289,7 @@ bool MemStrBuff<Tbuff, Tview>::DelStr(size_t n)
 {
     //LOG(DEBUG) << "DelStr " << n;
 
-    auto buff = GetBuff(n);
+    auto buff = GetBuff(n, true);
     if (!buff)
         return false;
 
@@ -692,6 +1303,7 @@ bool MemStrBuff<Tbuff, Tview>::DelStr(size_t n)
     
     --m_totalStrCount;
     m_changed = true;
+    m_buffList.Update(*buff);
 
     if ((**buff)->m_strOffsetList.empty())
     {
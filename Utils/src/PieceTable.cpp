@@ -0,0 +1,380 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/PieceTable.h"
+#include "utils/logger.h"
+
+namespace _Utils
+{
+
+bool StrIndex::Append(uint64_t end)
+{
+    uint64_t begin{ GetSize() };
+    if (end < begin)
+        return false;
+
+    if (m_strEnd.size() % c_blockStr == 0)
+        m_block.push_back(begin);
+    if (end - m_block.back() > UINT32_MAX)
+    {
+        //strings are limited in size, so block can't be so big
+        if (m_strEnd.size() % c_blockStr == 0)
+            m_block.pop_back();
+        return false;
+    }
+
+    m_strEnd.push_back(static_cast<uint32_t>(end - m_block.back()));
+    return true;
+}
+
+bool StrIndex::DelLast()
+{
+    if (m_strEnd.empty())
+        return false;
+
+    m_strEnd.pop_back();
+    if (m_strEnd.size() % c_blockStr == 0)
+        m_block.pop_back();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+template <typename Tbuff, typename Tview>
+Tview PieceTable<Tbuff, Tview>::GetSourceStr(const Piece& piece, size_t n) const
+{
+    n += piece.first;
+    if (piece.add)
+        return m_addStr[n];
+
+    uint64_t begin = m_origStr.GetBegin(n);
+    return m_orig.substr(static_cast<size_t>(begin), static_cast<size_t>(m_origStr.GetEnd(n) - begin));
+}
+
+template <typename Tbuff, typename Tview>
+size_t PieceTable<Tbuff, Tview>::AddSourceStr(const Tview str)
+{
+    if (m_addBuff.empty() || m_addBuff.back().capacity() - m_addBuff.back().size() < str.size())
+    {
+        //new buffer, old strings stay in place
+        m_addBuff.emplace_back();
+        m_addBuff.back().reserve(std::max(c_addBuffSize, str.size()));
+    }
+
+    auto& buff = m_addBuff.back();
+    size_t offset = buff.size();
+    buff.append(str);
+    m_addStr.emplace_back(buff.data() + offset, str.size());
+    m_addSize += str.size();
+
+    return m_addStr.size() - 1;
+}
+
+template <typename Tbuff, typename Tview>
+void PieceTable<Tbuff, Tview>::InsertPiece(size_t n, const Piece& piece)
+{
+    if (n >= GetStrCount())
+    {
+        //to the end
+        if (!m_pieceList.empty())
+        {
+            auto last = std::prev(m_pieceList.end());
+            if (last->add == piece.add && last->first + last->count == piece.first)
+            {
+                last->count += piece.count;
+                m_pieceList.Update(last);
+                return;
+            }
+        }
+        m_pieceList.push_back(piece);
+        return;
+    }
+
+    auto [it, firstStr] = m_pieceList.Find(n);
+    size_t offset = n - firstStr;
+    if (offset != 0)
+    {
+        //split piece, new one will be between parts
+        Piece tail{ it->add, it->first + offset, it->count - offset };
+        it->count = offset;
+        m_pieceList.Update(it);
+        it = m_pieceList.insert(std::next(it), tail);
+    }
+
+    if (it != m_pieceList.begin())
+    {
+        //add to previous piece if strings are continuous
+        auto prev = std::prev(it);
+        if (prev->add == piece.add && prev->first + prev->count == piece.first)
+        {
+            prev->count += piece.count;
+            m_pieceList.Update(prev);
+            return;
+        }
+    }
+    m_pieceList.insert(it, piece);
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::Compact()
+{
+    //strings used by pieces are copied to new buffers in order
+    std::deque<Tbuff> addBuff;
+    std::vector<Tview> addStr;
+    addBuff.swap(m_addBuff);
+    addStr.swap(m_addStr);
+    m_addSize = 0;
+    m_addFree = 0;
+
+    for (auto& piece : m_pieceList)
+    {
+        if (!piece.add)
+            continue;
+        size_t first = m_addStr.size();
+        for (size_t n = 0; n < piece.count; ++n)
+            AddSourceStr(addStr[piece.first + n]);
+        //number of strings is not changed, so tree is not updated
+        piece.first = first;
+    }
+
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::AppendOriginalStr(uint64_t end)
+{
+    if (end > m_orig.size() || !m_origStr.Append(end))
+        return false;
+
+    uint64_t begin = m_origStr.GetBegin(m_origStr.GetCount() - 1);
+    InsertPiece(GetStrCount(), { false, m_origStr.GetCount() - 1, 1 });
+    m_size += end - begin;
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::DelLastOriginalStr()
+{
+    if (m_pieceList.empty())
+        return false;
+
+    auto last = std::prev(m_pieceList.end());
+    if (last->add || last->first + last->count != m_origStr.GetCount())
+        return false;
+
+    m_size -= GetSourceStr(*last, last->count - 1).size();
+    if (last->count == 1)
+        m_pieceList.erase(last);
+    else
+    {
+        --last->count;
+        m_pieceList.Update(last);
+    }
+
+    return m_origStr.DelLast();
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::Rebase(const Tview data, StrIndex&& strEnd)
+{
+    Clear();
+
+    m_orig = data;
+    m_origStr = std::move(strEnd);
+    if (m_origStr.GetCount())
+    {
+        m_pieceList.push_back({ false, 0, m_origStr.GetCount() });
+        m_size = m_origStr.GetSize();
+    }
+
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::ForEachPart(const std::function<bool(const Tview)>& func) const
+{
+    for (const auto& piece : m_pieceList)
+    {
+        if (!piece.add)
+        {
+            //original strings are continuous
+            uint64_t begin = m_origStr.GetBegin(piece.first);
+            uint64_t end = m_origStr.GetEnd(piece.first + piece.count - 1);
+            if (!func(m_orig.substr(static_cast<size_t>(begin), static_cast<size_t>(end - begin))))
+                return false;
+            continue;
+        }
+
+        //join added strings from the same buffer
+        Tview part;
+        for (size_t n = 0; n < piece.count; ++n)
+        {
+            auto str = GetSourceStr(piece, n);
+            if (!part.empty() && part.data() + part.size() == str.data())
+                part = Tview(part.data(), part.size() + str.size());
+            else
+            {
+                if (!part.empty() && !func(part))
+                    return false;
+                part = str;
+            }
+        }
+        if (!part.empty() && !func(part))
+            return false;
+    }
+
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::Clear()
+{
+    m_orig = {};
+    m_origStr.Clear();
+    m_addBuff.clear();
+    m_addStr.clear();
+    m_addSize = 0;
+    m_addFree = 0;
+    m_pieceList.clear();
+    m_size = 0;
+    m_changed = false;
+
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+MemStat PieceTable<Tbuff, Tview>::GetMemStat() const
+{
+    MemStat stat;
+    stat.blocks = m_pieceList.size();
+    stat.strings = GetStrCount();
+    stat.dataSize = static_cast<size_t>(m_size);
+    for (const auto& buff : m_addBuff)
+        stat.poolSize += buff.capacity();
+    stat.offsetSize = m_origStr.GetMemSize() + m_addStr.capacity() * sizeof(Tview);
+    stat.infoSize = m_pieceList.size() * sizeof(Piece);
+
+    return stat;
+}
+
+template <typename Tbuff, typename Tview>
+Tview PieceTable<Tbuff, Tview>::GetStr(size_t n)
+{
+    if (n >= GetStrCount())
+        return {};
+
+    auto [it, firstStr] = m_pieceList.Find(n);
+    return GetSourceStr(*it, n - firstStr);
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::AddStr(size_t n, const Tview str)
+{
+    if (n > GetStrCount())
+        return false;
+
+    if (m_addFree > c_addBuffSize && m_addFree > m_addSize / 2)
+        //most of added data is deleted or changed
+        Compact();
+
+    size_t addStr = AddSourceStr(str);
+    InsertPiece(n, { true, addStr, 1 });
+
+    m_size += str.size();
+    m_changed = true;
+    return true;
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::ChangeStr(size_t n, const Tview str)
+{
+    if (n >= GetStrCount())
+        return false;
+
+    auto [it, firstStr] = m_pieceList.Find(n);
+    if (it->add && it->first + n - firstStr == m_addStr.size() - 1)
+    {
+        //the last added string is changed in place, so typing in the same string doesn't grow buffer
+        auto& buff = m_addBuff.back();
+        auto& last = m_addStr.back();
+        size_t begin = last.data() - buff.data();
+        bool alias = str.data() >= buff.data() && str.data() < buff.data() + buff.capacity();
+        if (!alias && begin + str.size() <= buff.capacity())
+        {
+            m_size = m_size - last.size() + str.size();
+            m_addSize = m_addSize - last.size() + str.size();
+            buff.resize(begin);
+            buff.append(str);
+            last = Tview(buff.data() + begin, str.size());
+            m_changed = true;
+            return true;
+        }
+    }
+
+    return DelStr(n) && AddStr(n, str);
+}
+
+template <typename Tbuff, typename Tview>
+bool PieceTable<Tbuff, Tview>::DelStr(size_t n)
+{
+    if (n >= GetStrCount())
+        return false;
+
+    auto [it, firstStr] = m_pieceList.Find(n);
+    size_t offset = n - firstStr;
+    auto size = GetSourceStr(*it, offset).size();
+    m_size -= size;
+    if (it->add)
+        m_addFree += size;
+    m_changed = true;
+
+    if (it->count == 1)
+        m_pieceList.erase(it);
+    else if (offset == 0)
+    {
+        ++it->first;
+        --it->count;
+        m_pieceList.Update(it);
+    }
+    else if (offset == it->count - 1)
+    {
+        --it->count;
+        m_pieceList.Update(it);
+    }
+    else
+    {
+        //cut string from the middle of piece
+        Piece tail{ it->add, it->first + offset + 1, it->count - offset - 1 };
+        it->count = offset;
+        m_pieceList.Update(it);
+        m_pieceList.insert(std::next(it), tail);
+    }
+
+    return true;
+}
+
+template class PieceTable<std::string, std::string_view>;
+
+} //namespace _Utils
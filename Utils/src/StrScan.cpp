@@ -0,0 +1,221 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/StrScan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define SCAN_X86
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+#endif
+
+#if defined(SCAN_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define SCAN_SSE2
+#endif
+
+#if defined(SCAN_X86) && (defined(__GNUC__) || defined(_MSC_VER))
+  #define SCAN_AVX2
+  #ifdef _MSC_VER
+    #define TARGET_AVX2
+  #else
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#endif
+
+namespace _Utils
+{
+
+static inline bool IsBreak(char c)
+{
+    return c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline unsigned FirstBit(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long n;
+    _BitScanForward(&n, mask);
+    return n;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+size_t StrScan::FindBreakScalar(const char* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        if (IsBreak(data[i]))
+            return i;
+    return size;
+}
+
+size_t StrScan::WidenAsciiScalar(const char* data, size_t size, char16_t* out)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (static_cast<unsigned char>(data[i]) >= 0x80)
+            return i;
+        out[i] = static_cast<char16_t>(data[i]);
+    }
+    return size;
+}
+
+#ifdef SCAN_SSE2
+static size_t FindBreakSse2(const char* data, size_t size)
+{
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(v, cr)), _mm_cmpeq_epi8(v, lf));
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+        if (mask)
+            return i + FirstBit(mask);
+    }
+    return i + StrScan::FindBreakScalar(data + i, size - i);
+}
+
+static size_t WidenAsciiSse2(const char* data, size_t size, char16_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        //block with not ASCII symbol is finished by scalar code
+        if (_mm_movemask_epi8(v))
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+    return i + StrScan::WidenAsciiScalar(data + i, size - i, out + i);
+}
+#endif
+
+#ifdef SCAN_AVX2
+TARGET_AVX2 static size_t FindBreakAvx2(const char* data, size_t size)
+{
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, tab), _mm256_cmpeq_epi8(v, cr)), _mm256_cmpeq_epi8(v, lf));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (mask)
+            return i + FirstBit(mask);
+    }
+    return i + StrScan::FindBreakScalar(data + i, size - i);
+}
+
+TARGET_AVX2 static size_t WidenAsciiAvx2(const char* data, size_t size, char16_t* out)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(v))
+            break;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+    }
+    return i + StrScan::WidenAsciiScalar(data + i, size - i, out + i);
+}
+
+static bool HasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    //OS must save AVX registers
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+using FindFunc = size_t (*)(const char* data, size_t size);
+using WidenFunc = size_t (*)(const char* data, size_t size, char16_t* out);
+
+struct ScanImpl
+{
+    FindFunc    func;
+    WidenFunc   widen;
+    const char* name;
+};
+
+static ScanImpl SelectImpl()
+{
+#ifdef SCAN_AVX2
+    if (HasAvx2())
+        return {FindBreakAvx2, WidenAsciiAvx2, "avx2"};
+#endif
+#ifdef SCAN_SSE2
+    return {FindBreakSse2, WidenAsciiSse2, "sse2"};
+#else
+    return {StrScan::FindBreakScalar, StrScan::WidenAsciiScalar, "scalar"};
+#endif
+}
+
+static const ScanImpl& GetScanImpl()
+{
+    static const ScanImpl impl{ SelectImpl() };
+    return impl;
+}
+
+size_t StrScan::FindBreak(const char* data, size_t size)
+{
+    return GetScanImpl().func(data, size);
+}
+
+size_t StrScan::WidenAscii(const char* data, size_t size, char16_t* out)
+{
+    return GetScanImpl().widen(data, size, out);
+}
+
+const char* StrScan::GetImpl()
+{
+    return GetScanImpl().name;
+}
+
+} // namespace _Utils
@@ -0,0 +1,187 @@
+/*
+FreeBSD License
+
+Copyright (c) 2020-2021 vikonix: valeriy.kovalev.software@gmail.com
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "utils/StreamSpool.h"
+#include "utils/logger.h"
+
+#include <string>
+#include <chrono>
+#include <cerrno>
+
+#ifdef WIN32
+    #include <windows.h>
+    #include <io.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <share.h>
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <poll.h>
+#endif
+
+namespace _Utils
+{
+
+bool StreamSpool::Create(const std::filesystem::path& dir, const std::string& name)
+{
+    //spool of other instance or file of other user is never reused
+#ifdef WIN32
+    auto prefix{ name + "-" + std::to_string(GetCurrentProcessId()) + "-" };
+    for (unsigned n = 0; n < 100 && m_file < 0; ++n)
+    {
+        m_path = dir / (prefix + std::to_string(GetTickCount() + n) + ".txt");
+        if (_wsopen_s(&m_file, m_path.wstring().c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY,
+            _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0 && errno != EEXIST)
+            break;
+    }
+#else
+    auto path{ (dir / (name + "-" + std::to_string(getpid()) + "-XXXXXX.txt")).string() };
+    m_file = mkstemps(path.data(), 4);
+    m_path = path;
+#endif
+    if (m_file < 0)
+    {
+        LOG(ERROR) << __FUNC__ << " create spool error=" << errno << " path=" << m_path.u8string();
+        m_file = -1;
+        m_path.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool StreamSpool::Open(int fd, const std::filesystem::path& dir, const std::string& name)
+{
+    Close();
+    if (fd < 0)
+        return false;
+
+    //empty spool file is created before pumping so it can be opened at once
+    if (!Create(dir, name))
+        return false;
+
+    m_fd = fd;
+    m_size = 0;
+    m_eof = false;
+    m_stop = false;
+    m_thread = std::thread([this]() { Pump(); });
+
+    LOG(DEBUG) << __FUNC__ << " fd=" << fd << " path=" << m_path.u8string();
+    return true;
+}
+
+void StreamSpool::Close(bool remove)
+{
+    if (m_fd < 0)
+        return;
+
+    m_stop = true;
+    if (m_thread.joinable())
+    {
+#ifdef WIN32
+        //blocked pipe reading can't be interrupted by timeout
+        CancelSynchronousIo(m_thread.native_handle());
+#endif
+        m_thread.join();
+    }
+
+#ifdef WIN32
+    _close(m_file);
+#else
+    close(m_file);
+#endif
+    m_file = -1;
+    m_fd = -1;
+    if (remove)
+    {
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+}
+
+bool StreamSpool::WaitData(uint32_t timeoutMs)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!m_size && !m_eof && std::chrono::steady_clock::now() < end)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return m_size || m_eof;
+}
+
+bool StreamSpool::Write(const char* data, size_t size)
+{
+    while (size)
+    {
+#ifdef WIN32
+        auto part = _write(m_file, data, static_cast<unsigned>(size));
+#else
+        auto part = write(m_file, data, size);
+        if (part < 0 && errno == EINTR)
+            continue;
+#endif
+        if (part <= 0)
+            return false;
+        data += part;
+        size -= static_cast<size_t>(part);
+    }
+    return true;
+}
+
+void StreamSpool::Pump()
+{
+    std::string buff(c_chunkSize, 0);
+
+    while (!m_stop)
+    {
+#ifndef WIN32
+        //check for stop while pipe is silent
+        pollfd pfd{ m_fd, POLLIN, 0 };
+        int rc = poll(&pfd, 1, 100);
+        if (rc == 0 || (rc < 0 && errno == EINTR))
+            continue;
+        auto read = ::read(m_fd, buff.data(), buff.size());
+        if (read < 0 && errno == EINTR)
+            continue;
+#else
+        auto read = _read(m_fd, buff.data(), static_cast<unsigned>(buff.size()));
+#endif
+        if (read <= 0)
+            break;
+
+        //data is written at once to be visible for the file readers
+        if (!Write(buff.data(), static_cast<size_t>(read)))
+        {
+            LOG(ERROR) << __FUNC__ << " spool write error=" << errno << " path=" << m_path.u8string();
+            break;
+        }
+        m_size += static_cast<uint64_t>(read);
+    }
+
+    LOG(DEBUG) << __FUNC__ << " end size=" << m_size;
+    m_eof = true;
+}
+
+} //namespace _Utils
@@ -31,8 +31,28 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "utils/logger.h"
 #include "utils/Directory.h"
 #include "utils/MemBuff.h"
+#include "utils/BuffTree.h"
+#include "utils/MappedFile.h"
+#include "utils/AsyncReader.h"
+#include "utils/StreamSpool.h"
+#include "utils/FileWatcher.h"
+#include "utils/AtomicFile.h"
+#include "utils/PieceTable.h"
+#include "utils/Lz.h"
+#include "utils/StrScan.h"
+#include "utils/CpConverter.h"
 
 #include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cerrno>
+
+#ifndef WIN32
+    #include <unistd.h>
+#endif
 
 /////////////////////////////////////////////////////////////////////////////
 using namespace _Utils;
@@ -74,6 +94,136 @@ void BuffTest()
         auto ptr = pool->GetBuffPointer(b);
         pool->ReleaseBuffPointer(b);
         pool->ReleaseBuff(b);
+        _assert(pool->GetStat().hits == 1);
+    }
+    {
+        //LRU order and lost blocks
+        auto pool = std::make_shared<BuffPool<std::string>>(2);
+        pool->SetMemoryLimit(2 * BUFF_SIZE);
+        auto b1 = pool->GetFreeBuff();
+        _assert(pool->GetBuffPointer(b1));
+        pool->ReleaseBuffPointer(b1);
+
+        auto b2 = pool->GetFreeBuff();
+        _assert(b2.index != b1.index);
+        _assert(pool->GetBuffPointer(b2));
+
+        //b1 is the last used not pinned block
+        auto b3 = pool->GetFreeBuff();
+        _assert(b3.index == b1.index && b3 != b1);
+        _assert(!pool->GetBuffPointer(b1));
+
+        [[maybe_unused]] auto stat = pool->GetStat();
+        _assert(stat.hits == 2 && stat.misses == 1 && stat.evictions == 1 && stat.allocated == 2);
+    }
+    {
+        //modified blocks are saved to swap file
+        auto pool = std::make_shared<BuffPool<std::string>>(1);
+        pool->SetMemoryLimit(BUFF_SIZE);
+        auto b1 = pool->GetFreeBuff();
+        auto ptr = pool->GetBuffPointer(b1);
+        *ptr = "modified block";
+        pool->ReleaseBuffPointer(b1, true);
+
+        auto b2 = pool->GetFreeBuff();
+        _assert(b2.index == b1.index);
+        _assert(!pool->GetBuffPointer(b1));
+        pool->ReleaseBuff(b2);
+
+        auto b3 = pool->GetFreeBuff();
+        auto restored = pool->GetBuffPointer(b3);
+        _assert(pool->RestoreBuff(b1, restored) && *restored == "modified block");
+        _assert(!pool->RestoreBuff(b1, restored));
+
+        [[maybe_unused]] auto stat = pool->GetStat();
+        _assert(stat.spills == 1 && stat.restores == 1 && stat.allocated == 1);
+    }
+    {
+        //swap path stays directory after error of swap file opening
+        std::filesystem::path dir{ "m-swap-test" };
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+        {
+            //file with the same name doesn't allow to create directory
+            std::ofstream block{ dir };
+        }
+
+        auto pool = std::make_shared<BuffPool<std::string>>(1);
+        pool->SetMemoryLimit(BUFF_SIZE);
+        pool->SetSwapPath(dir);
+        pool->SetPackLimit(0);
+        auto spill = [&pool]() {
+            auto b1 = pool->GetFreeBuff();
+            *pool->GetBuffPointer(b1) = "modified block";
+            pool->ReleaseBuffPointer(b1, true);
+            pool->ReleaseBuff(pool->GetFreeBuff());
+        };
+
+        spill();
+        _assert(pool->GetStat().spills == 0);
+        std::filesystem::remove(dir, ec);
+        std::filesystem::create_directories(dir, ec);
+        spill();
+        //block not saved before is swapped too
+        _assert(pool->GetStat().spills == 2);
+        pool.reset();
+        std::filesystem::remove_all(dir, ec);
+    }
+    {
+        //blocks of different size share memory limit
+        auto pool = std::make_shared<BuffPool<std::string>>(1);
+        pool->SetMemoryLimit(2 * BUFF_SIZE);
+        pool->SetPackLimit(0);
+        std::mt19937 gen{1};
+        std::string data(2 * BUFF_SIZE, 0);
+        for (auto& c : data)
+            c = static_cast<char>(gen());
+
+        auto b1 = pool->GetFreeBuff(2 * BUFF_SIZE);
+        auto ptr = pool->GetBuffPointer(b1);
+        _assert(ptr->capacity() >= 2 * BUFF_SIZE);
+        *ptr = data;
+        pool->ReleaseBuffPointer(b1, true);
+        ptr.reset();
+
+        auto b2 = pool->GetFreeBuff();
+        _assert(b2 != b1 && !pool->GetBuffPointer(b1));
+        pool->ReleaseBuff(b2);
+
+        auto b3 = pool->GetFreeBuff(2 * BUFF_SIZE);
+        auto restored = pool->GetBuffPointer(b3);
+        _assert(pool->RestoreBuff(b1, restored) && *restored == data);
+
+        [[maybe_unused]] auto stat = pool->GetStat();
+        _assert(stat.spills == 1 && stat.restores == 1 && stat.evictions == 1);
+    }
+    {
+        //cold blocks are compressed in memory and swapped over pack limit
+        auto pool = std::make_shared<BuffPool<std::string>>(1);
+        pool->SetMemoryLimit(BUFF_SIZE);
+        std::string text;
+        for (int i = 0; i < 1000; ++i)
+            text += "log line " + std::to_string(i) + "\n";
+
+        auto b1 = pool->GetFreeBuff();
+        *pool->GetBuffPointer(b1) = text;
+        pool->ReleaseBuffPointer(b1, true);
+
+        auto b2 = pool->GetFreeBuff();
+        _assert(b2.index == b1.index);
+        [[maybe_unused]] auto stat = pool->GetStat();
+        _assert(stat.packs == 1 && stat.spills == 0 && stat.packedSize < text.size() / 2);
+
+        auto restored = pool->GetBuffPointer(b2);
+        _assert(pool->RestoreBuff(b1, restored) && *restored == text);
+        pool->ReleaseBuffPointer(b2, true);
+
+        pool->SetPackLimit(1);
+        auto b3 = pool->GetFreeBuff();
+        stat = pool->GetStat();
+        _assert(stat.packs == 2 && stat.unpacks == 1 && stat.spills == 1 && stat.packedSize == 0);
+        restored = pool->GetBuffPointer(b3);
+        _assert(pool->RestoreBuff(b2, restored) && *restored == text);
     }
     {
         auto sbuff = std::make_unique<StrBuff<std::string, std::string_view>>();
@@ -90,9 +240,63 @@ void BuffTest()
         sstr << sbuff->GetStr(0) << sbuff->GetStr(1) << sbuff->GetStr(2);
 
         LOG(DEBUG) << sstr.str();
+        sbuff->CloseGap();
         LOG(DEBUG) << *(sbuff->GetBuff());
         _assert(sstr.str() == *(sbuff->GetBuff()));
     }
+    {
+        auto genStr = [](int i) ->std::string {
+            std::stringstream sstr;
+            sstr << "random str " << i << std::string(i % 100, '.') << std::endl;
+            return sstr.str();
+        };
+
+        //random access with reference model and small memory limit
+        auto limit = BuffPool<std::string>::s_pool.GetMemoryLimit();
+        auto packLimit = BuffPool<std::string>::s_pool.GetPackLimit();
+        BuffPool<std::string>::s_pool.SetMemoryLimit(4 * BUFF_SIZE);
+        BuffPool<std::string>::s_pool.SetPackLimit(BUFF_SIZE / 4);
+        std::mt19937 gen{1};
+        std::vector<std::string> model;
+        MemStrBuff<std::string, std::string_view> mbuff;
+        for (int i = 0; i < 50000; ++i)
+        {
+            auto op = gen() % 4;
+            if (op < 2 || model.empty())
+            {
+                size_t n = gen() % (model.size() + 1);
+                model.insert(model.begin() + n, genStr(i));
+                mbuff.AddStr(n, genStr(i));
+            }
+            else if (op == 2)
+            {
+                size_t n = gen() % model.size();
+                model[n] = genStr(i);
+                mbuff.ChangeStr(n, genStr(i));
+            }
+            else
+            {
+                size_t n = gen() % model.size();
+                model.erase(model.begin() + n);
+                mbuff.DelStr(n);
+            }
+        }
+        LOG(DEBUG) << "check random " << model.size();
+        _assert(mbuff.GetStrCount() == model.size());
+        for (size_t i = 0; i < model.size(); ++i)
+        {
+            [[maybe_unused]]auto str = mbuff.GetStr(i);
+            _assert(str == model[i]);
+        }
+        [[maybe_unused]] auto stat = BuffPool<std::string>::s_pool.GetStat();
+        LOG(DEBUG) << "packs=" << stat.packs << " unpacks=" << stat.unpacks << " spills=" << stat.spills << " restores=" << stat.restores;
+        _assert(stat.spills != 0 && stat.restores != 0 && stat.packs != 0 && stat.unpacks != 0);
+        [[maybe_unused]] auto mstat = mbuff.GetMemStat();
+        _assert(mstat.strings == model.size() && mstat.wideBlocks == 0 && mstat.offsetSize < model.size() * sizeof(uint32_t));
+        BuffPool<std::string>::s_pool.SetMemoryLimit(limit);
+        BuffPool<std::string>::s_pool.SetPackLimit(packLimit);
+        LOG(DEBUG) << "ok";
+    }
     {
         auto genStr = [](int i) ->std::string {
             std::stringstream sstr;
@@ -117,6 +321,746 @@ void BuffTest()
     }
 }
 
+void BuffTreeTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    struct Weight
+    {
+        size_t operator()(size_t v) const { return v; }
+    };
+
+    std::mt19937 gen{1};
+    std::list<size_t> model;
+    BuffTree<size_t, Weight> tree;
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        size_t n = gen() % (model.size() + 1);
+        size_t w = gen() % 10;
+        auto it = tree.begin();
+        auto mit = model.begin();
+        std::advance(it, n);
+        std::advance(mit, n);
+        if (gen() % 3 == 0 && mit != model.end())
+        {
+            tree.erase(it);
+            model.erase(mit);
+        }
+        else
+        {
+            tree.insert(it, w);
+            model.insert(mit, w);
+        }
+    }
+
+    _assert(tree.size() == model.size());
+    _assert(std::equal(tree.begin(), tree.end(), model.begin(), model.end()));
+
+    size_t first{};
+    for (auto it = tree.begin(); it != tree.end(); ++it)
+    {
+        if (*it)
+        {
+            [[maybe_unused]] auto [found, pos] = tree.Find(first + *it - 1);
+            _assert(found == it && pos == first);
+        }
+        first += *it;
+    }
+    _assert(tree.weight() == first);
+}
+
+
+void OffsetListTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    OffsetList list;
+    list.push_back(10);
+    list.insert(0, 5);
+    list.push_back(UINT16_MAX);
+    _assert(!list.IsWide() && list.size() == 3 && list[0] == 5 && list.back() == UINT16_MAX);
+
+    list.Set(1, 0x10000);
+    _assert(list.IsWide() && list[0] == 5 && list[1] == 0x10000 && list[2] == UINT16_MAX);
+    list.erase(0);
+    list.resize(1);
+    _assert(list.size() == 1 && list.back() == 0x10000);
+
+    list.clear();
+    _assert(list.empty() && !list.IsWide());
+}
+
+void GapBuffTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    //typing of Enter in the middle of dense block, with gap and with continuous data
+    std::vector<std::string> results;
+    for (bool gap : { false, true })
+    {
+        auto sbuff = std::make_unique<StrBuff<std::string, std::string_view>>();
+        sbuff->GetBuff();
+        for (int i = 0; i < 100; ++i)
+            sbuff->AppendStr("0123456789012345678901234567890123456789\n");
+
+        for (size_t i = 0; i < 500; ++i)
+        {
+            sbuff->AddStr(50 + i, "\n");
+            sbuff->ChangeStr(50 + i, "a\n");
+            if (!gap)
+                sbuff->CloseGap();
+        }
+
+        [[maybe_unused]] auto str = sbuff->GetStr(549);
+        _assert(sbuff->GetStrCount() == 600 && str == "a\n");
+        std::string data;
+        for (size_t i = 0; i < sbuff->GetStrCount(); ++i)
+            data += sbuff->GetStr(i);
+        results.push_back(data);
+    }
+    _assert(results[0] == results[1]);
+}
+
+void PoolThreadTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto limit = BuffPool<std::string>::s_pool.GetMemoryLimit();
+    BuffPool<std::string>::s_pool.SetMemoryLimit(12 * BUFF_SIZE);
+
+    //readers scan first blocks while main thread edits last ones
+    const size_t blocks{16};
+    const size_t strings{1000};
+    auto genStr = [](size_t b, size_t n) {
+        return "block " + std::to_string(b) + " str " + std::to_string(n) + "\n";
+    };
+
+    std::vector<std::shared_ptr<StrBuff<std::string, std::string_view>>> buffs;
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        auto buff = std::make_shared<StrBuff<std::string, std::string_view>>();
+        buff->GetBuff();
+        for (size_t n = 0; n < strings; ++n)
+            buff->AppendStr(genStr(b, n));
+        buff->ReleaseBuff();
+        buffs.push_back(buff);
+    }
+
+    //blocks taken from pool over limit are read from compressed copy or swap, they stay there for owner
+    auto stat = BuffPool<std::string>::s_pool.GetStat();
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        auto pin = buffs[b]->Pin();
+        _assert(pin && buffs[b]->GetStr(pin, strings - 1) == genStr(b, strings - 1));
+    }
+    _assert(BuffPool<std::string>::s_pool.GetStat().misses > stat.misses);
+    _assert(BuffPool<std::string>::s_pool.GetStat().unpacks == stat.unpacks);
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        _assert(buffs[b]->GetBuff() && buffs[b]->GetStr(0) == genStr(b, 0));
+        buffs[b]->ReleaseBuff();
+    }
+
+    std::atomic_bool stop{};
+    std::atomic<size_t> pinned{};
+    std::atomic<size_t> errors{};
+    auto reader = [&](unsigned seed) {
+        std::mt19937 gen{seed};
+        while (!stop)
+        {
+            size_t b = gen() % (blocks / 2);
+            auto pin = buffs[b]->Pin();
+            if (!pin)
+                continue;
+            ++pinned;
+            size_t n = gen() % strings;
+            if (buffs[b]->GetStr(pin, n) != genStr(b, n))
+                ++errors;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < 4; ++i)
+        threads.emplace_back(reader, i);
+
+    std::mt19937 gen{1};
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        auto& buff = buffs[blocks / 2 + gen() % (blocks / 2)];
+        buff->GetBuff();
+        buff->ChangeStr(gen() % strings, "edited " + std::to_string(i) + "\n");
+        buff->ReleaseBuff();
+    }
+
+    stop = true;
+    for (auto& t : threads)
+        t.join();
+
+    LOG(DEBUG) << "pinned=" << pinned << " errors=" << errors;
+    _assert(pinned != 0 && errors == 0);
+
+    buffs.clear();
+    BuffPool<std::string>::s_pool.SetMemoryLimit(limit);
+}
+
+void LzTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto check = [](const std::string& data) {
+        std::string packed;
+        if (!Lz::Compress(data.data(), data.size(), packed))
+            return false;
+        std::string unpacked(data.size(), 0);
+        [[maybe_unused]] bool rc = Lz::Decompress(packed.data(), packed.size(), unpacked.data(), unpacked.size());
+        _assert(rc && unpacked == data);
+        _assert(!Lz::Decompress(packed.data(), packed.size() - 1, unpacked.data(), unpacked.size()));
+        return true;
+    };
+
+    std::mt19937 gen{1};
+    std::string random(BUFF_SIZE, 0);
+    for (auto& c : random)
+        c = static_cast<char>(gen());
+    _assert(!check(random));
+    _assert(check(std::string(BUFF_SIZE, ' ')));
+    _assert(check("abcabcabcabcabcabc"));
+
+    //typical log block
+    std::string text;
+    for (int i = 0; text.size() < BUFF_SIZE - 100; ++i)
+        text += "2021-03-" + std::to_string(10 + i % 20) + " 12:" + std::to_string(10 + i % 50)
+            + " [INFO] request id=" + std::to_string(gen() % 100000) + " status=200 time=" + std::to_string(gen() % 1000) + "ms\n";
+    _assert(check(text));
+}
+
+void PieceTableTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    std::string orig;
+    std::vector<std::string> model;
+    for (int i = 0; i < 3000; ++i)
+    {
+        model.push_back("orig str " + std::to_string(i) + "\n");
+        orig += model.back();
+    }
+
+    PieceTable<std::string, std::string_view> table;
+    table.SetOriginal(orig);
+    uint64_t end{};
+    for (auto& str : model)
+        table.AppendOriginalStr(end += str.size());
+    _assert(table.GetPieceCount() == 1 && table.GetSize() == orig.size() && !table.IsChanged());
+
+    //random access with reference model
+    std::mt19937 gen{1};
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto op = gen() % 4;
+        auto str = "random str " + std::to_string(i) + "\n";
+        if (op < 2 || model.empty())
+        {
+            size_t n = gen() % (model.size() + 1);
+            model.insert(model.begin() + n, str);
+            table.AddStr(n, str);
+        }
+        else if (op == 2)
+        {
+            size_t n = gen() % model.size();
+            model[n] = str;
+            table.ChangeStr(n, str);
+        }
+        else
+        {
+            size_t n = gen() % model.size();
+            model.erase(model.begin() + n);
+            table.DelStr(n);
+        }
+    }
+
+    std::string data;
+    for (size_t i = 0; i < model.size(); ++i)
+    {
+        [[maybe_unused]] auto str = table.GetStr(i);
+        _assert(str == model[i]);
+        data += model[i];
+    }
+    _assert(table.GetStrCount() == model.size() && table.GetSize() == data.size());
+
+    std::string parts;
+    table.ForEachPart([&parts](std::string_view part) { parts += part; return true; });
+    _assert(parts == data);
+
+    //saved data becomes original
+    StrIndex strEnd;
+    end = 0;
+    for (auto& str : model)
+        strEnd.Append(end += str.size());
+    table.Rebase(parts, std::move(strEnd));
+    _assert(table.GetPieceCount() == 1 && table.GetStr(model.size() - 1) == model.back());
+    _assert(table.GetOriginalSize() == parts.size());
+
+    //typing in one string and changing of many strings don't grow added data
+    for (int i = 0; i < 10000; ++i)
+        table.ChangeStr(10, "typed " + std::to_string(i) + "\n");
+    for (int i = 0; i < 100000; ++i)
+        table.ChangeStr(gen() % model.size(), "changed " + std::to_string(i) + "\n");
+    [[maybe_unused]] auto stat = table.GetMemStat();
+    _assert(stat.poolSize <= 0x100000);
+
+    //log tail: not finished string is scanned again with new data
+    std::string log{ "first\nsecond\nthi" };
+    PieceTable<std::string, std::string_view> tail;
+    tail.SetOriginal(log);
+    tail.AppendOriginalStr(6);
+    tail.AppendOriginalStr(13);
+    tail.AppendOriginalStr(log.size());
+    log += "rd\nfourth\n";
+    tail.SetOriginal(log);
+    _assert(tail.DelLastOriginalStr() && tail.GetOriginalSize() == 13);
+    tail.AppendOriginalStr(19);
+    tail.AppendOriginalStr(log.size());
+    _assert(tail.GetStrCount() == 4 && tail.GetStr(2) == "third\n" && tail.GetSize() == log.size());
+    tail.ChangeStr(3, "changed\n");
+    _assert(!tail.DelLastOriginalStr());
+}
+
+void StrScanTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    std::mt19937 gen{1};
+    const char symbols[] = "ab \t\r\n";
+    std::string data(0x1000, 0);
+    for (int i = 0; i < 1000; ++i)
+    {
+        for (auto& c : data)
+            c = gen() % 50 ? 'x' : symbols[gen() % (sizeof(symbols) - 1)];
+        size_t begin = gen() % 64;
+        size_t size = gen() % (data.size() - begin);
+        [[maybe_unused]] auto pos = StrScan::FindBreak(data.data() + begin, size);
+        _assert(pos == StrScan::FindBreakScalar(data.data() + begin, size));
+    }
+
+    //string counting by bulk search is the same as by symbols
+    std::string text;
+    while (text.size() < 0x10000)
+        text += "2021-03-15 12:" + std::to_string(gen() % 60) + " [INFO]\tserver request id=" + std::to_string(gen())
+            + (gen() % 2 ? "\r\n" : "\n");
+
+    size_t strings{};
+    for (size_t i = 0; i < text.size(); ++i)
+        if (text[i] == '\n' || text[i] == '\r')
+            ++strings;
+    size_t found{};
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        i += StrScan::FindBreak(text.data() + i, text.size() - i);
+        if (i < text.size() && (text[i] == '\n' || text[i] == '\r'))
+            ++found;
+    }
+    _assert(strings == found);
+}
+
+//conversion by iconv only, as it was before built-in UTF-8 conversion
+static bool IconvConvert(iconv_t cd, std::string_view str, std::u16string& out)
+{
+    auto srcPtr = str.data();
+    size_t srcSize = str.size();
+    out.resize(srcSize * 2);
+    auto dstPtr = reinterpret_cast<char*>(out.data());
+    size_t dstSize = out.size() * 2;
+    size_t reserv = out.size();
+
+    bool rc{ true };
+    while (srcSize)
+    {
+        if (iconv(cd, &srcPtr, &srcSize, &dstPtr, &dstSize) == static_cast<size_t>(-1))
+        {
+            rc = false;
+            if (errno == EINVAL)
+                break;
+            ++srcPtr;
+            --srcSize;
+            *dstPtr++ = '?';
+            *dstPtr++ = 0;
+            dstSize -= 2;
+        }
+    }
+    out.resize(reserv - dstSize / 2);
+    return rc;
+}
+
+void CpConverterTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    std::mt19937 gen{1};
+    std::string data(0x200, 0);
+    std::u16string out1(data.size(), 0);
+    std::u16string out2(data.size(), 0);
+    for (int i = 0; i < 1000; ++i)
+    {
+        for (auto& c : data)
+            c = gen() % 40 ? static_cast<char>(' ' + gen() % 90) : static_cast<char>(0x80 + gen() % 0x80);
+        size_t begin = gen() % 64;
+        size_t size = gen() % (data.size() - begin);
+        [[maybe_unused]] auto len = StrScan::WidenAscii(data.data() + begin, size, out1.data());
+        _assert(len == StrScan::WidenAsciiScalar(data.data() + begin, size, out2.data()));
+        _assert(out1.compare(0, len, out2, 0, len) == 0);
+    }
+
+    //built-in conversion must give the same result as iconv, with invalid and incomplete symbols too
+    iconv_t utf8 = iconv_open("UTF-16LE", "UTF-8");
+    iconv_t cp1251 = iconv_open("UTF-16LE", "CP1251");
+    _assert(utf8 != (iconv_t)-1 && cp1251 != (iconv_t)-1);
+    iconvpp::CpConverter utf8Conv{ "UTF-8" };
+    iconvpp::CpConverter cp1251Conv{ "CP1251" };
+
+    const std::vector<std::string> parts{ "a", "int main() ", "\t", "\xd1\x8f", "\xe2\x82\xac", "\xe4\xb8\xad\xe6\x96\x87",
+        "\xf0\x9f\x98\x80", "\xff", "\x80", "\xc0\xaf", "\xe0\x80\x80", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe2\x82", "\xf0\x9f\x98" };
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::string str;
+        for (size_t n = gen() % 40; n > 0; --n)
+            str += parts[gen() % parts.size()];
+
+        [[maybe_unused]] bool rc1 = utf8Conv.Convert(str, out1);
+        [[maybe_unused]] bool rc2 = IconvConvert(utf8, str, out2);
+        _assert(rc1 == rc2 && out1 == out2);
+
+        rc1 = cp1251Conv.Convert(str, out1);
+        rc2 = IconvConvert(cp1251, str, out2);
+        _assert(rc1 == rc2 && out1 == out2);
+    }
+
+    for (uint32_t ch = 1; ch < 0x10000; ++ch)
+    {
+        std::string str;
+        if (!iconvpp::CpConverter::U16ToUtf8(static_cast<char16_t>(ch), str))
+        {
+            _assert(ch >= 0xd800 && ch <= 0xdfff);
+            continue;
+        }
+        [[maybe_unused]] bool rc = iconvpp::CpConverter::Utf8ToU16(str, out1);
+        _assert(rc && out1.size() == 1 && out1[0] == ch);
+    }
+
+    iconv_close(utf8);
+    iconv_close(cp1251);
+}
+
+void BlockSizeTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    //the same edits give the same text with any block size
+    std::string first;
+    for (size_t blockSize = BUFF_SIZE; blockSize <= MAX_BUFF_SIZE; blockSize *= 4)
+    {
+        MemStrBuff<std::string, std::string_view> mbuff;
+        mbuff.SetBlockSize(blockSize);
+        for (int i = 0; i < 20000; ++i)
+            mbuff.AppendStr("block size test string " + std::to_string(i) + "\n");
+
+        std::mt19937 gen{1};
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto op = gen() % 3;
+            size_t n = gen() % mbuff.GetStrCount();
+            if (op == 0)
+                mbuff.AddStr(n, "added string\n");
+            else if (op == 1)
+                mbuff.ChangeStr(n, "changed string " + std::to_string(i) + "\n");
+            else
+                mbuff.DelStr(n);
+        }
+
+        std::string data;
+        for (size_t i = 0; i < mbuff.GetStrCount(); ++i)
+            data += mbuff.GetStr(i);
+        if (first.empty())
+            first = data;
+        _assert(data == first);
+    }
+}
+
+void MappedFileTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto path = Directory::TmpPath("m") / "m-map.txt";
+    std::filesystem::create_directories(path.parent_path());
+    {
+        std::ofstream file{path, std::ios::binary};
+        file << "line 1\nline 2\n";
+    }
+
+    MappedFile mfile;
+    _assert(mfile.Open(path) && mfile.GetSize() == 14);
+    _assert(mfile.GetView(7, 7) == "line 2\n");
+    _assert(mfile.GetView(7, 8).empty());
+    mfile.Close();
+    _assert(!mfile.IsOpen() && mfile.GetView(0, 1).empty());
+
+#ifndef WIN32
+    //file truncated by other process is read as zeros
+    std::string data(0x10000, 'a');
+    {
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        file << data;
+    }
+    _assert(mfile.Open(path) && !mfile.IsTruncated());
+    std::filesystem::resize_file(path, 0x1000);
+    auto view = mfile.GetView(0, data.size());
+    _assert(view.size() == data.size() && view[0] == 'a');
+    _assert(view[0x8000] == 0 && view.back() == 0 && mfile.IsTruncated());
+    mfile.Close();
+    _assert(mfile.Open(path) && !mfile.IsTruncated());
+    mfile.Close();
+#endif
+
+    std::filesystem::remove(path);
+    _assert(!mfile.Open(path));
+}
+
+void AsyncReaderTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto path = Directory::TmpPath("m") / "m-read.txt";
+    std::filesystem::create_directories(path.parent_path());
+    std::string data;
+    std::mt19937 gen{ 3 };
+    for (size_t i = 0; i < 0x50000; ++i)
+        data += static_cast<char>('a' + gen() % 26);
+    {
+        std::ofstream file{ path, std::ios::binary };
+        file << data;
+    }
+
+    AsyncReader reader{ 3 };
+    _assert(reader.Open(path, true) && reader.GetSize() == data.size());
+
+    std::string buff(100, 0);
+    _assert(reader.Read(0x1000, 100, buff.data()) == 100 && buff == data.substr(0x1000, 100));
+    _assert(reader.Read(data.size() - 10, 100, buff.data()) == 10);
+    _assert(reader.Read(data.size(), 100, buff.data()) == 0);
+    reader.Prefetch(0, data.size());
+
+    //requests are taken in order of queueing
+    const size_t chunk{ 0x7000 };
+    for (uint64_t offset = 0; offset < data.size(); offset += chunk)
+        _assert(reader.Queue(offset, chunk));
+    std::shared_ptr<std::string> part;
+    std::string all;
+    while (size_t read = reader.Wait(part))
+    {
+        _assert(read == part->size());
+        all += *part;
+    }
+    _assert(all == data);
+    _assert(reader.Wait(part) == 0);
+
+    //close with requests in queue
+    for (uint64_t offset = 0; offset < data.size(); offset += chunk)
+        reader.Queue(offset, chunk);
+    reader.Close();
+    _assert(!reader.IsOpen() && reader.Wait(part) == 0);
+
+    MappedFile mfile;
+    _assert(mfile.Open(path));
+    mfile.Prefetch(0x1001, 0x10000);
+    mfile.Prefetch(data.size() - 1, 0x10000);
+    mfile.Close();
+
+    std::filesystem::remove(path);
+    _assert(!reader.Open(path));
+}
+
+void StreamSpoolTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+#ifndef WIN32
+    int fds[2];
+    _assert(pipe(fds) == 0);
+
+    auto dir = Directory::TmpPath("m");
+    std::filesystem::create_directories(dir);
+    StreamSpool spool;
+    _assert(spool.Open(fds[0], dir, "m-spool") && std::filesystem::exists(spool.GetPath()));
+    auto path = spool.GetPath();
+    _assert(!spool.WaitData(10));
+
+    //every stream has its own spool file
+    StreamSpool other;
+    int fds2[2];
+    _assert(pipe(fds2) == 0);
+    _assert(other.Open(fds2[0], dir, "m-spool") && other.GetPath() != path);
+    other.Close();
+    _assert(!std::filesystem::exists(other.GetPath()) && std::filesystem::exists(path));
+    close(fds2[0]);
+    close(fds2[1]);
+
+    std::string data;
+    for (size_t i = 0; i < 0x8000; ++i)
+        data += "line " + std::to_string(i) + "\n";
+
+    //spool file grows while data arrives
+    _assert(write(fds[1], data.data(), 100) == 100);
+    _assert(spool.WaitData(1000) && !spool.IsEof());
+    for (size_t offset = 100; offset < data.size();)
+    {
+        auto rc = write(fds[1], data.data() + offset, std::min<size_t>(0x3000, data.size() - offset));
+        _assert(rc > 0);
+        offset += rc;
+    }
+    close(fds[1]);
+
+    for (size_t i = 0; i < 1000 && !spool.IsEof(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    _assert(spool.IsEof() && spool.GetSize() == data.size());
+    {
+        std::ifstream file{ path, std::ios::binary };
+        std::string spooled{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        _assert(spooled == data);
+    }
+
+    spool.Close();
+    _assert(!spool.IsOpen() && !std::filesystem::exists(path));
+    close(fds[0]);
+
+    //stop while pipe is silent
+    _assert(pipe(fds) == 0);
+    _assert(spool.Open(fds[0], dir, "m-spool"));
+    spool.Close();
+    _assert(!spool.IsEof() || spool.GetSize() == 0);
+    close(fds[0]);
+    close(fds[1]);
+#endif
+}
+
+void FileWatcherTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto& watcher = FileWatcher::getInstance();
+    auto path = Directory::TmpPath("m") / "m-watch.txt";
+    std::filesystem::create_directories(path.parent_path());
+    {
+        std::ofstream file{ path, std::ios::binary };
+        file << "line\n";
+    }
+
+    auto id = watcher.Add(path);
+    if (!watcher.IsAvailable())
+    {
+        //files are polled
+        _assert(id == FileWatcher::c_invalid);
+        std::filesystem::remove(path);
+        return;
+    }
+    _assert(id != FileWatcher::c_invalid);
+    _assert(watcher.Add(path) == id);
+    _assert(watcher.TakeEvents(id) == watch_none);
+
+    auto waitEvents = [&watcher](FileWatcher::watch_t id) {
+        uint32_t events{};
+        for (size_t i = 0; i < 200 && !events; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            events = watcher.TakeEvents(id);
+        }
+        return events;
+    };
+
+    {
+        std::ofstream file{ path, std::ios::binary | std::ios::app };
+        file << "appended\n";
+    }
+    _assert(waitEvents(id) == watch_changed);
+    _assert(watcher.TakeEvents(id) == watch_none);
+
+    //watch is lost with deleted file
+    std::filesystem::remove(path);
+    _assert(waitEvents(id) & watch_removed);
+    _assert(watcher.TakeEvents(id) & watch_removed);
+    watcher.Remove(id);
+    watcher.Remove(id);
+    _assert(watcher.Add(path) == FileWatcher::c_invalid);
+}
+
+void AtomicFileTest()
+{
+    LOG(DEBUG) << "Test: " << __FUNC__;
+
+    auto path = Directory::TmpPath("m") / "m-atomic.txt";
+    std::filesystem::create_directories(path.parent_path());
+    std::string data;
+    for (size_t i = 0; i < 0x10000; ++i)
+        data += "line " + std::to_string(i) + "\n";
+    {
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        file << data;
+    }
+    auto readAll = [&path]() {
+        std::ifstream file{ path, std::ios::binary };
+        return std::string{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    };
+
+    //changed middle and copied ranges of original file
+    AtomicFile file;
+    _assert(file.Open(path) && std::filesystem::exists(file.GetTmpPath()));
+    _assert(file.Copy(0, 1000));
+    _assert(file.Write("changed\n", 8));
+    _assert(file.Copy(2000, data.size() - 2000));
+    _assert(file.GetSize() == data.size() - 1000 + 8);
+    //original file is the same till commit
+    _assert(readAll() == data);
+    _assert(file.Commit());
+    _assert(!file.IsOpen() && !std::filesystem::exists(file.GetTmpPath()));
+    auto expected = data.substr(0, 1000) + "changed\n" + data.substr(2000);
+    _assert(readAll() == expected);
+
+    //discarded file doesn't change original
+    _assert(file.Open(path));
+    _assert(file.Write("x", 1));
+    _assert(!file.Copy(expected.size() - 10, 20));
+    file.Discard();
+    _assert(!std::filesystem::exists(file.GetTmpPath()) && readAll() == expected);
+
+    //file with name of old temporary one is not touched
+    auto userPath{ path };
+    userPath += ".tmp";
+    {
+        std::ofstream user{ userPath, std::ios::binary | std::ios::trunc };
+        user << "user";
+    }
+    _assert(file.Open(path) && file.GetTmpPath() != userPath);
+    auto tmpPath{ file.GetTmpPath() };
+    AtomicFile file2;
+    _assert(file2.Open(path) && file2.GetTmpPath() != tmpPath);
+    file2.Discard();
+    _assert(file.Write("new\n", 4) && file.Commit());
+    _assert(readAll() == "new\n" && std::filesystem::file_size(userPath) == 4);
+    std::filesystem::remove(userPath);
+
+    //links are overwritten in place
+    std::error_code ec;
+    auto linkPath{ path };
+    linkPath += ".lnk";
+    std::filesystem::create_symlink(path, linkPath, ec);
+    _assert(!ec && !file.Open(linkPath) && !file.IsOpen());
+    std::filesystem::remove(linkPath);
+    std::filesystem::create_hard_link(path, linkPath, ec);
+    _assert(!ec && !file.Open(path));
+    std::filesystem::remove(linkPath);
+    _assert(file.Open(path));
+    file.Discard();
+
+    std::filesystem::remove(path);
+}
 
 int main()
 {
@@ -125,7 +1069,21 @@ int main()
     LOG(INFO) << "Utils test";
     std::cout << "Utils test starts...";
 
+    BuffTreeTest();
     BuffTest();
+    OffsetListTest();
+    GapBuffTest();
+    LzTest();
+    PoolThreadTest();
+    PieceTableTest();
+    StrScanTest();
+    CpConverterTest();
+    BlockSizeTest();
+    MappedFileTest();
+    AsyncReaderTest();
+    StreamSpoolTest();
+    FileWatcherTest();
+    AtomicFileTest();
     CheckDirectoryFunc();
 
     std::cout << "Utils test finished";
@@ -135,6 +135,8 @@ public:
     bool    Refresh() { return m_wndManager.Refresh(); }
 
     bool    PutCode(input_t code) { return m_wndManager.m_console.PutInput(code); }
+    //main loop gets K_TIME at once, it can be called from any thread
+    void    WakeInput() { m_wndManager.m_console.Wake(); }
     bool    RecordMacro();
     bool    PlayMacro();
     bool    PutMacro(input_t code);
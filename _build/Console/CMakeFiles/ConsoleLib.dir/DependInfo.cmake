@@ -0,0 +1,28 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Console/src/CastKeyCode.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/CastKeyCode.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/CastKeyCode.cpp.o.d"
+  "/root/repo/Console/src/tty/InputTTY.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/tty/InputTTY.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/tty/InputTTY.cpp.o.d"
+  "/root/repo/Console/src/tty/KeyMap.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/tty/KeyMap.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/tty/KeyMap.cpp.o.d"
+  "/root/repo/Console/src/tty/Mouse.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/tty/Mouse.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/tty/Mouse.cpp.o.d"
+  "/root/repo/Console/src/tty/ScreenTTY.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/tty/ScreenTTY.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/tty/ScreenTTY.cpp.o.d"
+  "/root/repo/Console/src/tty/TermcapMap.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/tty/TermcapMap.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/tty/TermcapMap.cpp.o.d"
+  "/root/repo/Console/src/win32/InputWin32.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/win32/InputWin32.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/win32/InputWin32.cpp.o.d"
+  "/root/repo/Console/src/win32/ScreenWin32.cpp" "Console/CMakeFiles/ConsoleLib.dir/src/win32/ScreenWin32.cpp.o" "gcc" "Console/CMakeFiles/ConsoleLib.dir/src/win32/ScreenWin32.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_build/ThirdParty/CMakeFiles/ThirdPartyLib.dir/DependInfo.cmake"
+  "/root/repo/_build/Utils/CMakeFiles/UtilsLib.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
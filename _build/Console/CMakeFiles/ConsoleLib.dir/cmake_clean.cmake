@@ -0,0 +1,25 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ConsoleLib.dir/src/CastKeyCode.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/CastKeyCode.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/tty/InputTTY.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/tty/InputTTY.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/tty/KeyMap.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/tty/KeyMap.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/tty/Mouse.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/tty/Mouse.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/tty/ScreenTTY.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/tty/ScreenTTY.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/tty/TermcapMap.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/tty/TermcapMap.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/win32/InputWin32.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/win32/InputWin32.cpp.o.d"
+  "CMakeFiles/ConsoleLib.dir/src/win32/ScreenWin32.cpp.o"
+  "CMakeFiles/ConsoleLib.dir/src/win32/ScreenWin32.cpp.o.d"
+  "libConsoleLib.a"
+  "libConsoleLib.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ConsoleLib.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,41 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Editor/src/Config.cpp" "Editor/CMakeFiles/multitextor.dir/src/Config.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Config.cpp.o.d"
+  "/root/repo/Editor/src/Dialogs/FileDialog.cpp" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/FileDialog.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/FileDialog.cpp.o.d"
+  "/root/repo/Editor/src/Dialogs/FindDialog.cpp" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/FindDialog.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/FindDialog.cpp.o.d"
+  "/root/repo/Editor/src/Dialogs/FindFileDialog.cpp" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/FindFileDialog.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/FindFileDialog.cpp.o.d"
+  "/root/repo/Editor/src/Dialogs/GotoDialog.cpp" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/GotoDialog.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/GotoDialog.cpp.o.d"
+  "/root/repo/Editor/src/Dialogs/PropertiesDialog.cpp" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/PropertiesDialog.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/PropertiesDialog.cpp.o.d"
+  "/root/repo/Editor/src/Dialogs/WindowListDialog.cpp" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/WindowListDialog.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Dialogs/WindowListDialog.cpp.o.d"
+  "/root/repo/Editor/src/Editor.cpp" "Editor/CMakeFiles/multitextor.dir/src/Editor.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/Editor.cpp.o.d"
+  "/root/repo/Editor/src/EditorApp.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorApp.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorApp.cpp.o.d"
+  "/root/repo/Editor/src/EditorAppFunc.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorAppFunc.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorAppFunc.cpp.o.d"
+  "/root/repo/Editor/src/EditorCmd.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorCmd.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorCmd.cpp.o.d"
+  "/root/repo/Editor/src/EditorMenu.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorMenu.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorMenu.cpp.o.d"
+  "/root/repo/Editor/src/EditorWnd.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorWnd.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorWnd.cpp.o.d"
+  "/root/repo/Editor/src/EditorWndDialogs.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorWndDialogs.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorWndDialogs.cpp.o.d"
+  "/root/repo/Editor/src/EditorWndEditFunc.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorWndEditFunc.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorWndEditFunc.cpp.o.d"
+  "/root/repo/Editor/src/EditorWndMoveFunc.cpp" "Editor/CMakeFiles/multitextor.dir/src/EditorWndMoveFunc.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/EditorWndMoveFunc.cpp.o.d"
+  "/root/repo/Editor/src/LexParser.cpp" "Editor/CMakeFiles/multitextor.dir/src/LexParser.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/LexParser.cpp.o.d"
+  "/root/repo/Editor/src/UndoList.cpp" "Editor/CMakeFiles/multitextor.dir/src/UndoList.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/UndoList.cpp.o.d"
+  "/root/repo/Editor/src/main.cpp" "Editor/CMakeFiles/multitextor.dir/src/main.cpp.o" "gcc" "Editor/CMakeFiles/multitextor.dir/src/main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_build/ThirdParty/CMakeFiles/ThirdPartyLib.dir/DependInfo.cmake"
+  "/root/repo/_build/Utils/CMakeFiles/UtilsLib.dir/DependInfo.cmake"
+  "/root/repo/_build/Console/CMakeFiles/ConsoleLib.dir/DependInfo.cmake"
+  "/root/repo/_build/WndManager/CMakeFiles/WndManagerLib.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
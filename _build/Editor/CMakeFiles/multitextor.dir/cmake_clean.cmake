@@ -0,0 +1,47 @@
+file(REMOVE_RECURSE
+  "../bin/multitextor"
+  "../bin/multitextor.pdb"
+  "CMakeFiles/multitextor.dir/src/Config.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Config.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Dialogs/FileDialog.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Dialogs/FileDialog.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Dialogs/FindDialog.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Dialogs/FindDialog.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Dialogs/FindFileDialog.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Dialogs/FindFileDialog.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Dialogs/GotoDialog.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Dialogs/GotoDialog.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Dialogs/PropertiesDialog.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Dialogs/PropertiesDialog.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Dialogs/WindowListDialog.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Dialogs/WindowListDialog.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/Editor.cpp.o"
+  "CMakeFiles/multitextor.dir/src/Editor.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorApp.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorApp.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorAppFunc.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorAppFunc.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorCmd.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorCmd.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorMenu.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorMenu.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorWnd.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorWnd.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorWndDialogs.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorWndDialogs.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorWndEditFunc.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorWndEditFunc.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/EditorWndMoveFunc.cpp.o"
+  "CMakeFiles/multitextor.dir/src/EditorWndMoveFunc.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/LexParser.cpp.o"
+  "CMakeFiles/multitextor.dir/src/LexParser.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/UndoList.cpp.o"
+  "CMakeFiles/multitextor.dir/src/UndoList.cpp.o.d"
+  "CMakeFiles/multitextor.dir/src/main.cpp.o"
+  "CMakeFiles/multitextor.dir/src/main.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/multitextor.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
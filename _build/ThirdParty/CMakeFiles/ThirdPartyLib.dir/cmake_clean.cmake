@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ThirdPartyLib.dir/src/easyloggingpp/easylogging++.cc.o"
+  "CMakeFiles/ThirdPartyLib.dir/src/easyloggingpp/easylogging++.cc.o.d"
+  "libThirdPartyLib.a"
+  "libThirdPartyLib.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ThirdPartyLib.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
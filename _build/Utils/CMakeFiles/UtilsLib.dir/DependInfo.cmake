@@ -0,0 +1,33 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Utils/src/AsyncReader.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/AsyncReader.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/AsyncReader.cpp.o.d"
+  "/root/repo/Utils/src/AtomicFile.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/AtomicFile.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/AtomicFile.cpp.o.d"
+  "/root/repo/Utils/src/Clipboard.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/Clipboard.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/Clipboard.cpp.o.d"
+  "/root/repo/Utils/src/CpConverter.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/CpConverter.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/CpConverter.cpp.o.d"
+  "/root/repo/Utils/src/Directory.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/Directory.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/Directory.cpp.o.d"
+  "/root/repo/Utils/src/FileWatcher.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/FileWatcher.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/FileWatcher.cpp.o.d"
+  "/root/repo/Utils/src/Lz.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/Lz.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/Lz.cpp.o.d"
+  "/root/repo/Utils/src/MappedFile.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/MappedFile.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/MappedFile.cpp.o.d"
+  "/root/repo/Utils/src/MemBuff.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/MemBuff.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/MemBuff.cpp.o.d"
+  "/root/repo/Utils/src/PieceTable.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/PieceTable.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/PieceTable.cpp.o.d"
+  "/root/repo/Utils/src/StrScan.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/StrScan.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/StrScan.cpp.o.d"
+  "/root/repo/Utils/src/StreamSpool.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/StreamSpool.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/StreamSpool.cpp.o.d"
+  "/root/repo/Utils/src/SymbolType.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/SymbolType.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/SymbolType.cpp.o.d"
+  "/root/repo/Utils/src/logger.cpp" "Utils/CMakeFiles/UtilsLib.dir/src/logger.cpp.o" "gcc" "Utils/CMakeFiles/UtilsLib.dir/src/logger.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_build/ThirdParty/CMakeFiles/ThirdPartyLib.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,37 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/UtilsLib.dir/src/AsyncReader.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/AsyncReader.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/AtomicFile.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/AtomicFile.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/Clipboard.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/Clipboard.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/CpConverter.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/CpConverter.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/Directory.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/Directory.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/FileWatcher.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/FileWatcher.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/Lz.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/Lz.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/MappedFile.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/MappedFile.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/MemBuff.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/MemBuff.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/PieceTable.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/PieceTable.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/StrScan.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/StrScan.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/StreamSpool.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/StreamSpool.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/SymbolType.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/SymbolType.cpp.o.d"
+  "CMakeFiles/UtilsLib.dir/src/logger.cpp.o"
+  "CMakeFiles/UtilsLib.dir/src/logger.cpp.o.d"
+  "libUtilsLib.a"
+  "libUtilsLib.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/UtilsLib.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,30 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/WndManager/src/App.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/App.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/App.cpp.o.d"
+  "/root/repo/WndManager/src/CmdParser.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/CmdParser.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/CmdParser.cpp.o.d"
+  "/root/repo/WndManager/src/ColorMap.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/ColorMap.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/ColorMap.cpp.o.d"
+  "/root/repo/WndManager/src/Dialog.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/Dialog.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/Dialog.cpp.o.d"
+  "/root/repo/WndManager/src/DlgControls.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/DlgControls.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/DlgControls.cpp.o.d"
+  "/root/repo/WndManager/src/Menu.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/Menu.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/Menu.cpp.o.d"
+  "/root/repo/WndManager/src/Wnd.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/Wnd.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/Wnd.cpp.o.d"
+  "/root/repo/WndManager/src/WndManager.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/WndManager.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/WndManager.cpp.o.d"
+  "/root/repo/WndManager/src/WndShade.cpp" "WndManager/CMakeFiles/WndManagerLib.dir/src/WndShade.cpp.o" "gcc" "WndManager/CMakeFiles/WndManagerLib.dir/src/WndShade.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_build/ThirdParty/CMakeFiles/ThirdPartyLib.dir/DependInfo.cmake"
+  "/root/repo/_build/Utils/CMakeFiles/UtilsLib.dir/DependInfo.cmake"
+  "/root/repo/_build/Console/CMakeFiles/ConsoleLib.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/WndManagerLib.dir/src/App.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/App.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/CmdParser.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/CmdParser.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/ColorMap.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/ColorMap.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/Dialog.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/Dialog.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/DlgControls.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/DlgControls.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/Menu.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/Menu.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/Wnd.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/Wnd.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/WndManager.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/WndManager.cpp.o.d"
+  "CMakeFiles/WndManagerLib.dir/src/WndShade.cpp.o"
+  "CMakeFiles/WndManagerLib.dir/src/WndShade.cpp.o.d"
+  "libWndManagerLib.a"
+  "libWndManagerLib.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/WndManagerLib.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()